@@ -1,226 +1,728 @@
 #include <iostream>
 #include <string>
 #include <vector>
-#include <map>
-#include <iomanip>
+#include <unordered_map>
 #include <algorithm>
 #include <limits>
+#include <cstdint>
+#include <fstream>
+#include <string_view>
+#include <cstring>
+#include <cerrno>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "tokenizer.h"
+#include "output.h"
+#include "wal.h"
+#include "warehouse.h"
+#include "stats.h"
 using namespace std;
 
-class Warehouse {
+// Склад в каталоге данных: снимок плотного состояния ячеек и журнал изменений
+// после него. При запуске читается снимок и проигрывается только хвост журнала.
+// Когда журнал вырастает до SNAPSHOT_BYTES, пишется новый снимок следующего
+// поколения, и журнал начинается заново (файлы snapshot и wal.<поколение>)
+class WarehouseStorage {
 private:
-    struct Cell {
-        string address;
-        string product;
-        int quantity;
-    };
-
-    int zones;
-    int shelves_per_zone;
-    int sections_per_shelf;
-    int shelves_per_section;
-    int total_capacity;
-    int used_capacity = 0;
+    static constexpr uint64_t SNAPSHOT_BYTES = 1 << 20;
+    static constexpr char SNAPSHOT_MAGIC[8] = {'W', 'H', 'S', 'N', 'A', 'P', '0', '1'};
+
+    Warehouse& warehouse;
+    string dir;
+    SyncPolicy policy;
+    uint64_t generation = 0;
+    WriteAheadLog wal;
+    Output* guarded = nullptr;
+    bool failed = false;  // журнал не записан: последние операции не подтверждены
+
+    string LogPath(uint64_t number) const {
+        return dir + "/wal." + to_string(number);
+    }
 
-    map<string, Cell> cells;
+    template <typename T>
+    static void Write(string& data, T value) {
+        data.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
 
-public:
-    Warehouse(int z, int spz, int sec, int spl, int cap) 
-        : zones(z), shelves_per_zone(spz), sections_per_shelf(sec), 
-          shelves_per_section(spl), total_capacity(cap) {}
-
-    bool Address(const string& address) {
-        if (address.length() != 5) return false;
-        
-        char zone = address[0];
-        if (zone < 'A' || zone >= 'A' + zones) return false;
-        
-        int shelf = stoi(address.substr(1, 2));
-        if (shelf < 1 || shelf > shelves_per_zone) return false;
-        
-        int section = address[3] - '0';
-        if (section < 1 || section > sections_per_shelf) return false;
-        
-        int shelf_num = address[4] - '0';
-        if (shelf_num < 1 || shelf_num > shelves_per_section) return false;
-        
+    template <typename T>
+    static bool Read(string_view& data, T& value) {
+        if (data.size() < sizeof(value)) return false;
+        memcpy(&value, data.data(), sizeof(value));
+        data.remove_prefix(sizeof(value));
         return true;
     }
 
-    void ADD(const string& product, int quantity, const string& address) {
-        if (!Address(address)) {
-            cout << "Ошибка: Неверный адрес: " << address << endl;
-            return;
+    // Снимок: заголовок, названия товаров, количества и товары всех ячеек, crc32 в конце
+    bool LoadSnapshot() {
+        ifstream file(dir + "/snapshot", ios::binary);
+        if (!file) return true;
+        string data((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+        if (data.size() < sizeof(uint32_t)) return false;
+
+        uint32_t stored_crc;
+        memcpy(&stored_crc, data.data() + data.size() - sizeof(stored_crc), sizeof(stored_crc));
+        string_view rest(data.data(), data.size() - sizeof(stored_crc));
+        if (crc32(rest.data(), rest.size()) != stored_crc) return false;
+        if (rest.size() < sizeof(SNAPSHOT_MAGIC) || memcmp(rest.data(), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+            return false;
         }
-
-        if (quantity > 10) {
-            cout << "Ошибка: Нельзя добавить более 10 единиц в ячейку" << endl;
-            return;
+        rest.remove_prefix(sizeof(SNAPSHOT_MAGIC));
+
+        uint32_t cells, products;
+        if (!Read(rest, generation) || !Read(rest, cells) || !Read(rest, products)) return false;
+        if (cells != static_cast<uint32_t>(warehouse.CellCount())) return false;
+        for (uint32_t id = 0; id < products; ++id) {
+            uint32_t length;
+            if (!Read(rest, length) || rest.size() < length) return false;
+            if (!warehouse.ReplayProduct(static_cast<int>(id), string(rest.substr(0, length)))) return false;
+            rest.remove_prefix(length);
         }
+        if (rest.size() != cells * 2 * sizeof(int32_t)) return false;
+        for (uint32_t slot = 0; slot < cells; ++slot) {
+            int32_t quantity, product;
+            memcpy(&quantity, rest.data() + slot * sizeof(int32_t), sizeof(quantity));
+            memcpy(&product, rest.data() + (cells + slot) * sizeof(int32_t), sizeof(product));
+            if (quantity > 0 && !warehouse.ReplayChange(static_cast<int>(slot), product, quantity)) return false;
+        }
+        return true;
+    }
 
-        if (cells.count(address)) {
-            Cell& cell = cells[address];
-            if (cell.product != product) {
-                cout << "Ошибка: Ячейка " << address << " уже содержит " << cell.product << endl;
-                return;
+    // Кадр журнала - одна операция или новый товар: последовательность записей LogRecord.
+    // operations считает кадры с изменениями ячеек
+    bool ReplayFrame(string_view frame, int& operations) {
+        bool changes = false;
+        while (!frame.empty()) {
+            uint8_t type;
+            Read(frame, type);
+            if (type == static_cast<uint8_t>(LogRecord::PRODUCT)) {
+                int32_t id, length;
+                if (!Read(frame, id) || !Read(frame, length) || length < 0 || frame.size() < static_cast<size_t>(length)) {
+                    return false;
+                }
+                if (!warehouse.ReplayProduct(id, string(frame.substr(0, length)))) return false;
+                frame.remove_prefix(length);
+            } else if (type == static_cast<uint8_t>(LogRecord::CHANGE)) {
+                int32_t slot, product, delta;
+                if (!Read(frame, slot) || !Read(frame, product) || !Read(frame, delta)) return false;
+                if (!warehouse.ReplayChange(slot, product, delta)) return false;
+                changes = true;
+            } else {
+                return false;
             }
-            if (cell.quantity + quantity > 10) {
-                cout << "Ошибка: Ячейка " << address << " не может содержать более 10 единиц (сейчас: " << cell.quantity << ")" << endl;
-                return;
-            }
-            cell.quantity += quantity;
-        } else {
-            cells[address] = {address, product, quantity};
         }
-        used_capacity += quantity;
-        cout << "Добавлено " << quantity << " единиц " << product << " в " << address << endl;
+        if (changes) ++operations;
+        return true;
     }
 
-    void REMOVE(const string& product, int quantity, const string& address) {
-        if (!Address(address)) {
-            cout << "Ошибка: Неверный адрес: " << address << endl;
-            return;
+    bool WriteSnapshot(uint64_t number) {
+        string data(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+        const vector<string>& names = warehouse.ProductNames();
+        uint32_t cells = static_cast<uint32_t>(warehouse.CellCount());
+        Write(data, number);
+        Write(data, cells);
+        Write(data, static_cast<uint32_t>(names.size()));
+        for (const string& name : names) {
+            Write(data, static_cast<uint32_t>(name.size()));
+            data += name;
         }
-
-        if (!cells.count(address)) {
-            cout << "Ошибка: Ячейка " << address << " пуста" << endl;
-            return;
+        for (uint32_t slot = 0; slot < cells; ++slot) {
+            Write(data, static_cast<int32_t>(warehouse.CellQuantity(slot)));
         }
-
-        Cell& cell = cells[address];
-        if (cell.product != product) {
-            cout << "Ошибка: Ячейка " << address << " содержит " << cell.product << ", а не " << product << endl;
-            return;
+        for (uint32_t slot = 0; slot < cells; ++slot) {
+            Write(data, static_cast<int32_t>(warehouse.CellProduct(slot)));
         }
+        Write(data, crc32(data.data(), data.size()));
+        return writeFileDurably(dir, "snapshot", data);
+    }
 
-        if (cell.quantity < quantity) {
-            cout << "Ошибка: Недостаточно " << product << " в ячейке " << address << " (доступно: " << cell.quantity << ")" << endl;
-            return;
-        }
+public:
+    explicit WarehouseStorage(Warehouse& w) : warehouse(w) {}
 
-        cell.quantity -= quantity;
-        used_capacity -= quantity;
-        cout << "Удалено " << quantity << " единиц " << product << " из " << address << endl;
+    WarehouseStorage(const WarehouseStorage&) = delete;
+    WarehouseStorage& operator=(const WarehouseStorage&) = delete;
 
-        if (cell.quantity == 0) {
-            cells.erase(address);
-        }
+    ~WarehouseStorage() {
+        Close();
     }
 
-    void INFO() {
-        double total_percent = (static_cast<double>(used_capacity) / total_capacity) * 100;
-        cout << fixed << setprecision(1);
-        cout << "Информация о складе:" << endl;
-        cout << "Общая заполненность: " << total_percent << "%" << endl;
+    // Восстанавливает склад из каталога и подключает журнал; replayed - число операций из журнала
+    bool Open(const string& directory, SyncPolicy sync_policy, int& replayed) {
+        dir = directory;
+        policy = sync_policy;
+        replayed = 0;
+        if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) return false;
+        if (!LoadSnapshot()) return false;
+
+        // Журнал прошлого поколения мог остаться, если сбой случился сразу после снимка
+        if (generation > 0) unlink(LogPath(generation - 1).c_str());
+        bool ok = wal.open(LogPath(generation), policy, [&](string_view frame) {
+            return ReplayFrame(frame, replayed);
+        });
+        if (!ok) return false;
+        warehouse.AttachLog(&wal);
+        return true;
+    }
 
-        map<char, int> zone_capacity;
-        map<char, int> zone_used;
-        
-        for (char zone = 'A'; zone < 'A' + zones; ++zone) {
-            zone_capacity[zone] = shelves_per_zone * sections_per_shelf * shelves_per_section * 10;
-            zone_used[zone] = 0;
-        }
+    uint64_t Generation() const {
+        return generation;
+    }
 
-        for (const auto& pair : cells) {
-            char zone = pair.first[0];
-            zone_used[zone] += pair.second.quantity;
-        }
+    // Вызывается между командами: при большом журнале пишет снимок и начинает новый журнал
+    void Checkpoint() {
+        // Снимок не пишется после ошибки журнала: в нём оказались бы неподтверждённые операции
+        if (!wal.isOpen() || wal.bytes() < SNAPSHOT_BYTES || !Idle()) return;
+        Snapshot();
+    }
 
-        for (char zone = 'A'; zone < 'A' + zones; ++zone) {
-            double zone_percent = (static_cast<double>(zone_used[zone]) / zone_capacity[zone]) * 100;
-            cout << "Зона " << zone << " заполнена на " << zone_percent << "%" << endl;
+    bool Snapshot() {
+        if (!WriteSnapshot(generation + 1)) return false;
+        wal.close();
+        ++generation;
+        unlink(LogPath(generation).c_str());
+        if (!wal.open(LogPath(generation), policy, [](string_view) { return false; })) {
+            warehouse.AttachLog(nullptr);
+            return false;
         }
+        unlink(LogPath(generation - 1).c_str());
+        return true;
+    }
+
+    // Групповая фиксация перед ожиданием ввода; false, если журнал не удалось записать
+    bool Idle() {
+        if (!failed && !wal.sync()) failed = true;
+        return !failed;
+    }
 
-        cout << "\nЗанятые ячейки:" << endl;
-        for (const auto& pair : cells) {
-            cout << pair.first << ": " << pair.second.product << " (" << pair.second.quantity << ")" << endl;
+    bool Failed() const {
+        return failed;
+    }
+
+    // Ответы в sink уходят клиенту только после фиксации журнала: подтверждённая
+    // операция не теряется при сбое между ответом и fsync. Если журнал не записан,
+    // ответы отбрасываются
+    void GuardOutput(Output& sink) {
+        guarded = &sink;
+        sink.setBeforeFlush([](void* storage) { return static_cast<WarehouseStorage*>(storage)->Idle(); }, this);
+    }
+
+    void Close() {
+        if (guarded) {
+            guarded->setBeforeFlush(nullptr, nullptr);
+            guarded = nullptr;
         }
+        if (!wal.isOpen()) return;
+        if (wal.bytes() > 0 && Idle()) Snapshot();
+        warehouse.AttachLog(nullptr);
+        wal.close();
+    }
+};
+
+enum class Command {
+    ADD,
+    REMOVE,
+    INFO,
+    CELLS,
+    FIND,
+    STOCK,
+    COUNT,
+    EMPTY,
+    CLEAR,
+    BEGIN,
+    COMMIT,
+    ROLLBACK,
+    LOAD,
+    UNDO,
+    REDO,
+    STATS,
+    EXIT,
+    UNKNOWN
+};
 
-        int total_cells = zones * shelves_per_zone * sections_per_shelf * shelves_per_section;
-        int empty_cells = total_cells - cells.size();
-        cout << "\nПустые ячейки: " << empty_cells << endl;
+Command parseCommand(string_view word) {
+    switch (commandHash(word)) {
+        case commandHash("ADD"): if (word == "ADD") return Command::ADD; break;
+        case commandHash("REMOVE"): if (word == "REMOVE") return Command::REMOVE; break;
+        case commandHash("INFO"): if (word == "INFO") return Command::INFO; break;
+        case commandHash("CELLS"): if (word == "CELLS") return Command::CELLS; break;
+        case commandHash("FIND"): if (word == "FIND") return Command::FIND; break;
+        case commandHash("STOCK"): if (word == "STOCK") return Command::STOCK; break;
+        case commandHash("COUNT"): if (word == "COUNT") return Command::COUNT; break;
+        case commandHash("EMPTY"): if (word == "EMPTY") return Command::EMPTY; break;
+        case commandHash("CLEAR"): if (word == "CLEAR") return Command::CLEAR; break;
+        case commandHash("BEGIN"): if (word == "BEGIN") return Command::BEGIN; break;
+        case commandHash("COMMIT"): if (word == "COMMIT") return Command::COMMIT; break;
+        case commandHash("ROLLBACK"): if (word == "ROLLBACK") return Command::ROLLBACK; break;
+        case commandHash("LOAD"): if (word == "LOAD") return Command::LOAD; break;
+        case commandHash("UNDO"): if (word == "UNDO") return Command::UNDO; break;
+        case commandHash("REDO"): if (word == "REDO") return Command::REDO; break;
+        case commandHash("STATS"): if (word == "STATS") return Command::STATS; break;
+        case commandHash("EXIT"): if (word == "EXIT") return Command::EXIT; break;
     }
+    return Command::UNKNOWN;
+}
+
+struct Operation {
+    bool add;
+    string product;
+    int quantity;
+    string address;  // пустой адрес - ячейки подбираются автоматически
 };
 
-int main() {
-    Warehouse warehouse(1, 10, 7, 4, 2800);
-    string command;
-    while (true) {
-        cout << ">>> ";
-        if (!getline(cin, command)) {
-            cin.clear();
-            cout << "Ошибка: Неправильный ввод команды" << endl;
-            continue;
+// Разбирает аргументы ADD/REMOVE; при ошибке формата возвращает false и текст ошибки.
+// Строки op переиспользуются, поэтому на потоке команд разбор не выделяет память
+bool ParseOperation(Command cmd, Tokenizer& tokens, Operation& op, string& error) {
+    op.add = cmd == Command::ADD;
+    const char* name = op.add ? "ADD" : "REMOVE";
+
+    string_view product = tokens.next();
+    string_view quantity = tokens.next();
+    // Без адреса ячейки подбираются автоматически
+    string_view address = tokens.next();
+    if (product.empty() || quantity.empty() || !tokens.empty()) {
+        error = string("Неправильный формат команды ") + name + ". Используйте: " + name
+                + " <продукт> <количество> [<адрес>]";
+        return false;
+    }
+
+    Tokenizer number(quantity);
+    if (!number.nextInt(op.quantity)) {
+        error = "Неправильный формат количества. Должно быть целое число";
+        return false;
+    }
+    op.product.assign(product);
+    op.address.assign(address);
+    return true;
+}
+
+void ApplyOperation(Warehouse& warehouse, const Operation& op) {
+    if (op.add) {
+        if (op.address.empty()) {
+            warehouse.ADD(op.product, op.quantity);
+        } else {
+            warehouse.ADD(op.product, op.quantity, op.address);
         }
+    } else {
+        if (op.address.empty()) {
+            warehouse.REMOVE(op.product, op.quantity);
+        } else {
+            warehouse.REMOVE(op.product, op.quantity, op.address);
+        }
+    }
+}
 
-        if (command.empty()) {
-            continue;
+// Применяет пакет целиком или, при первой ошибке, откатывает его и сообщает причину
+void CommitBatch(Warehouse& warehouse, const vector<Operation>& batch) {
+    warehouse.BeginBatch();
+    long long added = 0;
+    long long removed = 0;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        const Operation& op = batch[i];
+        bool ok;
+        if (op.add) {
+            ok = op.address.empty() ? warehouse.TryAdd(op.product, op.quantity)
+                                    : warehouse.TryAdd(op.product, op.quantity, op.address);
+        } else {
+            ok = op.address.empty() ? warehouse.TryRemove(op.product, op.quantity)
+                                    : warehouse.TryRemove(op.product, op.quantity, op.address);
+        }
+        if (!ok) {
+            warehouse.RollbackBatch();
+            out << "Ошибка: Пакет отменён, операция " << i + 1 << ": " << warehouse.LastError() << '\n';
+            return;
         }
+        (op.add ? added : removed) += op.quantity;
+    }
+    warehouse.CommitBatch();
+    out << "Пакет применён: " << batch.size() << " операций, добавлено " << added
+        << " единиц, удалено " << removed << " единиц" << '\n';
+}
 
-        // Разбиваем команду на части
-        size_t space1 = command.find(' ');
-        string cmd = command.substr(0, space1);
+// Читает поток команд ADD/REMOVE как один пакет
+bool LoadBatch(istream& in, vector<Operation>& batch) {
+    string line;
+    Operation op;
+    string error;
+    for (int line_number = 1; readLine(in, line); ++line_number) {
+        Tokenizer tokens(line);
+        if (tokens.empty()) continue;
+        Command cmd = parseCommand(tokens.next());
+        if (cmd != Command::ADD && cmd != Command::REMOVE) {
+            out << "Ошибка: Строка " << line_number << ": в пакете допустимы только ADD и REMOVE" << '\n';
+            return false;
+        }
+        if (!ParseOperation(cmd, tokens, op, error)) {
+            out << "Ошибка: Строка " << line_number << ": " << error << '\n';
+            return false;
+        }
+        batch.push_back(op);
+    }
+    return true;
+}
 
-        if (cmd == "ADD") {
-            size_t space2 = command.find(' ', space1 + 1);
-            if (space1 == string::npos || space2 == string::npos) {
-                cout << "Ошибка: Неправильный формат команды ADD. Используйте: ADD <продукт> <количество> <адрес>" << endl;
-                continue;
-            }
+bool LoadFile(Warehouse& warehouse, const string& path) {
+    vector<Operation> batch;
+    if (path == "-") {
+        if (!LoadBatch(cin, batch)) return false;
+    } else {
+        ifstream file(path);
+        if (!file) {
+            out << "Ошибка: Не удалось открыть файл " << path << '\n';
+            return false;
+        }
+        if (!LoadBatch(file, batch)) return false;
+    }
+    CommitBatch(warehouse, batch);
+    return true;
+}
 
-            string product = command.substr(space1 + 1, space2 - space1 - 1);
-            string rest = command.substr(space2 + 1);
+// Один поток команд параллельного режима: ответы пишутся в свой sink,
+// склад общий и блокируется по зонам
+void RunStream(ShardedWarehouse& warehouse, istream& in, Output& sink) {
+    string line;
+    Operation op;
+    string error;
+    string argument;
+    while (readLine(in, line)) {
+        Tokenizer tokens(line);
+        if (tokens.empty()) continue;
+        string_view word = tokens.next();
+        Command cmd = parseCommand(word);
+        switch (cmd) {
+            case Command::ADD:
+            case Command::REMOVE:
+                if (!ParseOperation(cmd, tokens, op, error)) {
+                    sink << "Ошибка: " << error << '\n';
+                } else if (op.add) {
+                    if (op.address.empty()) {
+                        warehouse.ADD(op.product, op.quantity, sink);
+                    } else {
+                        warehouse.ADD(op.product, op.quantity, op.address, sink);
+                    }
+                } else {
+                    if (op.address.empty()) {
+                        warehouse.REMOVE(op.product, op.quantity, sink);
+                    } else {
+                        warehouse.REMOVE(op.product, op.quantity, op.address, sink);
+                    }
+                }
+                break;
+            case Command::INFO:
+                warehouse.INFO(sink);
+                break;
+            case Command::FIND:
+            case Command::STOCK:
+                argument.assign(tokens.next());
+                if (argument.empty() || !tokens.empty()) {
+                    sink << "Ошибка: Неправильный формат команды " << word << ". Используйте: " << word << " <продукт>" << '\n';
+                } else if (cmd == Command::FIND) {
+                    warehouse.FIND(argument, sink);
+                } else {
+                    warehouse.STOCK(argument, sink);
+                }
+                break;
+            case Command::CELLS: {
+                argument.assign(tokens.next());
+                int limit = numeric_limits<int>::max();
+                if (!tokens.empty() && (!tokens.nextInt(limit) || limit <= 0)) {
+                    sink << "Ошибка: Количество должно быть положительным числом" << '\n';
+                    break;
+                }
+                warehouse.CELLS(argument, limit, sink);
+                break;
+            }
+            case Command::EXIT:
+                return;
+            default:
+                sink << "Ошибка: В параллельном режиме допустимы только ADD, REMOVE, INFO, CELLS, FIND, STOCK, EXIT" << '\n';
+                break;
+        }
+    }
+}
 
-            size_t space3 = rest.find(' ');
-            if (space3 == string::npos) {
-                cout << "Ошибка: Неправильный формат команды ADD. Используйте: ADD <продукт> <количество> <адрес>" << endl;
-                continue;
+// Параллельный режим: каждый файл команд - отдельный поток, ответы - в <файл>.out,
+// в конце печатается итоговое состояние склада
+int RunParallel(int zones, const vector<string>& files) {
+    ShardedWarehouse warehouse(zones, 10, 7, 4, 2800);
+    vector<thread> threads;
+    vector<char> failed(files.size(), 0);
+    for (size_t i = 0; i < files.size(); ++i) {
+        threads.emplace_back([&warehouse, &files, &failed, i] {
+            ifstream in(files[i]);
+            int fd = open((files[i] + ".out").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (!in || fd < 0) {
+                failed[i] = 1;
+                if (fd >= 0) close(fd);
+                return;
             }
+            {
+                auto sink = make_unique<Output>(fd);
+                RunStream(warehouse, in, *sink);
+            }
+            close(fd);
+        });
+    }
+    for (thread& t : threads) {
+        t.join();
+    }
 
-            string quantityStr = rest.substr(0, space3);
-            string address = rest.substr(space3 + 1);
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (failed[i]) out << "Ошибка: Не удалось открыть файл " << files[i] << '\n';
+    }
+    out << "Обработано потоков: " << files.size() << '\n';
+    warehouse.INFO(out);
+    return 0;
+}
 
-            try {
-                int quantity = stoi(quantityStr);
-                warehouse.ADD(product, quantity, address);
-            } catch (...) {
-                cout << "Ошибка: Неправильный формат количества. Должно быть целое число" << endl;
+int main(int argc, char* argv[]) {
+    ios::sync_with_stdio(false);
+    configureOutput(argc, argv);
+    configureStats(argc, argv);
+    stats.setCommands({"ADD", "REMOVE", "INFO", "CELLS", "FIND", "STOCK", "COUNT", "EMPTY", "CLEAR", "BEGIN", "COMMIT", "ROLLBACK",
+                       "LOAD", "UNDO", "REDO", "STATS", "EXIT"});
+
+    // --zones <n> - число зон (A, B, ...), --parallel <файл>... - параллельный режим
+    int zones = 1;
+    vector<string> parallel_files;
+    bool durable = false;
+    for (int i = 1; i < argc; ++i) {
+        string option = argv[i];
+        if (option == "--data-dir" || option == "--fsync") durable = true;
+        if (option == "--zones" && i + 1 < argc) {
+            zones = atoi(argv[++i]);
+            if (zones < 1 || zones > 26) {
+                out << "Ошибка: Число зон должно быть от 1 до 26" << '\n';
+                return 1;
             }
-        } 
-        else if (cmd == "REMOVE") {
-            size_t space2 = command.find(' ', space1 + 1);
-            if (space1 == string::npos || space2 == string::npos) {
-                cout << "Ошибка: Неправильный формат команды REMOVE. Используйте: REMOVE <продукт> <количество> <адрес>" << endl;
-                continue;
+        } else if (option == "--parallel") {
+            while (i + 1 < argc && string(argv[i + 1]).rfind("--", 0) != 0) {
+                parallel_files.push_back(argv[++i]);
             }
+        }
+    }
+    if (!parallel_files.empty()) {
+        // Шарды параллельного режима не ведут журнал, поэтому хранение на диске с ним несовместимо
+        if (durable) {
+            out << "Ошибка: --data-dir и --fsync нельзя использовать вместе с --parallel" << '\n';
+            return 1;
+        }
+        return RunParallel(zones, parallel_files);
+    }
 
-            string product = command.substr(space1 + 1, space2 - space1 - 1);
-            string rest = command.substr(space2 + 1);
-
-            size_t space3 = rest.find(' ');
-            if (space3 == string::npos) {
-                cout << "Ошибка: Неправильный формат команды REMOVE. Используйте: REMOVE <продукт> <количество> <адрес>" << endl;
-                continue;
+    Warehouse warehouse(zones, 10, 7, 4, 2800 * zones);
+    WarehouseStorage storage(warehouse);
+
+    // --data-dir <каталог> хранит склад на диске, --fsync always|group|off задаёт сброс журнала
+    string data_dir;
+    SyncPolicy policy = SyncPolicy::GROUP;
+    for (int i = 1; i < argc; ++i) {
+        string option = argv[i];
+        if (option == "--data-dir" && i + 1 < argc) {
+            data_dir = argv[++i];
+        } else if (option == "--fsync") {
+            string mode = i + 1 < argc ? argv[++i] : "";
+            if (!parseSyncPolicy(mode, policy)) {
+                out << "Ошибка: Неизвестный режим --fsync" << (mode.empty() ? "" : " " + mode) << ". Используйте: always, group, off" << '\n';
+                return 1;
             }
+        }
+    }
+    if (!data_dir.empty()) {
+        int replayed;
+        if (!storage.Open(data_dir, policy, replayed)) {
+            out << "Ошибка: Не удалось восстановить склад из " << data_dir << '\n';
+            return 1;
+        }
+        storage.GuardOutput(out);
+        out << "Склад восстановлен из " << data_dir << ": снимок " << storage.Generation()
+            << ", операций из журнала " << replayed << '\n';
+    }
 
-            string quantityStr = rest.substr(0, space3);
-            string address = rest.substr(space3 + 1);
+    // --load <файл> загружает файл одним пакетом, "-" - весь stdin без интерактивного режима
+    for (int i = 1; i < argc; ++i) {
+        if (string(argv[i]) == "--load" && i + 1 < argc) {
+            string path = argv[++i];
+            LoadFile(warehouse, path);
+            if (path == "-") return 0;
+        }
+    }
 
-            try {
-                int quantity = stoi(quantityStr);
-                warehouse.REMOVE(product, quantity, address);
-            } catch (...) {
-                cout << "Ошибка: Неправильный формат количества. Должно быть целое число" << endl;
+    string command;
+    bool in_batch = false;
+    vector<Operation> batch;
+    Operation op;
+    string error;
+    string argument;
+    while (true) {
+        storage.Checkpoint();
+        stats.tick();
+        out << ">>> ";
+        // Перед ожиданием ввода накопленные операции фиксируются одним fsync;
+        // сброс ответов и сам ждёт журнала (GuardOutput)
+        if (cin.rdbuf()->in_avail() <= 0) storage.Idle();
+        out.flushIfInteractive();
+        if (storage.Failed()) {
+            // Ответы на незаписанные операции отбрасываются; склад перестаёт принимать команды
+            out.flush();
+            storage.Close();
+            out << "Ошибка: Не удалось записать журнал в " << data_dir
+                << ", последние операции не сохранены. Работа остановлена" << '\n';
+            return 1;
+        }
+        if (!readLine(cin, command)) {
+            if (cin.eof()) {
+                // Незавершённый пакет не применяется, но об этом сообщается явно
+                if (in_batch) out << "Пакет не завершён, отменён: " << batch.size() << " операций" << '\n';
+                break;
             }
+            cin.clear();
+            out << "Ошибка: Неправильный ввод команды" << '\n';
+            continue;
         }
-        else if (cmd == "INFO") {
-            warehouse.INFO();
+
+        StatTimer timer;
+        Tokenizer tokens(command);
+        if (tokens.empty()) {
+            continue;
         }
-        else if (cmd == "EXIT") {
-            break;
+
+        string_view word = tokens.next();
+        Command cmd = parseCommand(word);
+        timer.command(static_cast<int>(cmd));
+
+        if (in_batch) {
+            if (cmd == Command::ADD || cmd == Command::REMOVE) {
+                if (ParseOperation(cmd, tokens, op, error)) {
+                    batch.push_back(op);
+                } else {
+                    out << "Ошибка: " << error << '\n';
+                }
+            } else if (cmd == Command::COMMIT) {
+                CommitBatch(warehouse, batch);
+                batch.clear();
+                in_batch = false;
+            } else if (cmd == Command::ROLLBACK) {
+                out << "Пакет отменён: " << batch.size() << " операций" << '\n';
+                batch.clear();
+                in_batch = false;
+            } else {
+                out << "Ошибка: Внутри пакета допустимы только ADD, REMOVE, COMMIT, ROLLBACK" << '\n';
+            }
+            continue;
         }
-        else {
-            cout << "Ошибка: Неизвестная команда '" << cmd << "'. Доступные команды: ADD, REMOVE, INFO, EXIT" << endl;
+
+        switch (cmd) {
+            case Command::ADD:
+            case Command::REMOVE:
+                if (ParseOperation(cmd, tokens, op, error)) {
+                    ApplyOperation(warehouse, op);
+                } else {
+                    out << "Ошибка: " << error << '\n';
+                }
+                break;
+            case Command::BEGIN:
+                in_batch = true;
+                break;
+            case Command::LOAD:
+                if (tokens.empty()) {
+                    out << "Ошибка: Неправильный формат команды LOAD. Используйте: LOAD <файл>" << '\n';
+                    break;
+                }
+                LoadFile(warehouse, string(tokens.remainder()));
+                break;
+            case Command::INFO:
+                warehouse.INFO();
+                break;
+            case Command::FIND:
+            case Command::STOCK: {
+                string_view product = tokens.next();
+                if (product.empty() || !tokens.empty()) {
+                    out << "Ошибка: Неправильный формат команды " << word << ". Используйте: " << word << " <продукт>" << '\n';
+                    break;
+                }
+                argument.assign(product);
+                if (cmd == Command::FIND) {
+                    warehouse.FIND(argument);
+                } else {
+                    warehouse.STOCK(argument);
+                }
+                break;
+            }
+            case Command::CELLS: {
+                // CELLS [адрес] [количество]
+                argument.assign(tokens.next());
+                int limit = numeric_limits<int>::max();
+                if (!tokens.empty()) {
+                    if (!tokens.nextInt(limit)) {
+                        out << "Ошибка: Неправильный формат количества. Должно быть целое число" << '\n';
+                        break;
+                    }
+                    if (limit <= 0) {
+                        out << "Ошибка: Количество должно быть положительным числом" << '\n';
+                        break;
+                    }
+                }
+                warehouse.CELLS(argument, limit);
+                break;
+            }
+            case Command::COUNT:
+            case Command::CLEAR:
+            case Command::EMPTY: {
+                // COUNT|CLEAR <диапазон>, EMPTY <диапазон> [количество]
+                argument.assign(tokens.next());
+                int limit = numeric_limits<int>::max();
+                if (cmd == Command::EMPTY && !argument.empty() && !tokens.empty()) {
+                    if (!tokens.nextInt(limit) || limit <= 0) {
+                        out << "Ошибка: Количество должно быть положительным числом" << '\n';
+                        break;
+                    }
+                }
+                if (argument.empty() || !tokens.empty()) {
+                    out << "Ошибка: Неправильный формат команды " << word << ". Используйте: " << word
+                        << " <префикс адреса или диапазон>" << (cmd == Command::EMPTY ? " [количество]" : "")
+                        << ", например A, A03, A035 или A01-A03" << '\n';
+                    break;
+                }
+                if (cmd == Command::COUNT) {
+                    warehouse.COUNT(argument);
+                } else if (cmd == Command::EMPTY) {
+                    warehouse.EMPTY(argument, limit);
+                } else {
+                    warehouse.CLEAR(argument);
+                }
+                break;
+            }
+            case Command::UNDO:
+            case Command::REDO: {
+                statPhase(Phase::APPLY);
+                size_t changes = cmd == Command::UNDO ? warehouse.Undo() : warehouse.Redo();
+                statPhase(Phase::PRINT);
+                if (changes == 0) {
+                    out << "Ошибка: " << (cmd == Command::UNDO ? "Нечего отменять" : "Нечего повторять") << '\n';
+                } else {
+                    out << (cmd == Command::UNDO ? "Отменено" : "Повторено") << ": изменено ячеек " << changes << '\n';
+                }
+                break;
+            }
+            case Command::STATS:
+                // STATS [ON|OFF|RESET]
+                argument.assign(tokens.next());
+                if (!tokens.empty() || !statsCommand(argument, out)) {
+                    out << "Ошибка: Неправильный формат команды STATS. Используйте: STATS [ON|OFF|RESET]" << '\n';
+                }
+                break;
+            case Command::COMMIT:
+            case Command::ROLLBACK:
+                out << "Ошибка: Нет открытого пакета. Начните его командой BEGIN" << '\n';
+                break;
+            case Command::EXIT:
+                return 0;
+            case Command::UNKNOWN:
+                out << "Ошибка: Неизвестная команда '" << word << "'. Доступные команды: ADD, REMOVE, INFO, CELLS, FIND, STOCK, COUNT, EMPTY, CLEAR, BEGIN, LOAD, UNDO, REDO, STATS, EXIT" << '\n';
+                break;
         }
     }
     return 0;
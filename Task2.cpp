@@ -1,23 +1,24 @@
 #include <iostream>
 #include <vector>
 #include <queue>
+#include <set>
+#include <chrono>
 #include <string>
 #include <algorithm>
+#include <functional>
 #include <iomanip>
 #include <sstream>
-#include <limits>
+#include <string_view>
+#include <cstdlib>
+#include <cerrno>
+#include <cctype>
+#include "tokenizer.h"
+#include "output.h"
+#include "stats.h"
+#include "visitor_queue.h"
+#include "queue_simulation.h"
 using namespace std;
 
-struct Visitor {
-    string ticket;
-    int duration;
-};
-
-struct Window {
-    int total_time = 0;
-    vector<Visitor> visitors;
-};
-
 string generate_ticket() {
     static int counter = 1;
     stringstream ss;
@@ -25,88 +26,616 @@ string generate_ticket() {
     return ss.str();
 }
 
-vector<Window> distribute_queue(queue<Visitor>& q, int windows_count) {
-    vector<Window> windows(windows_count);
+// LPT: самые долгие посетители распределяются первыми
+vector<Window> distribute_lpt(vector<Visitor> visitors, int windows_count) {
+    stable_sort(visitors.begin(), visitors.end(), [](const Visitor& a, const Visitor& b) {
+        return a.duration > b.duration;
+    });
+    queue<Visitor> q;
+    for (Visitor& visitor : visitors) {
+        q.push(move(visitor));
+    }
+    return distribute_queue(q, windows_count);
+}
+
+// Локальное улучшение: посетитель из самого загруженного окна переносится в другое окно
+// или меняется местами с более коротким посетителем, если это уменьшает загрузку
+void refine(vector<Window>& windows) {
+    const int MAX_STEPS = 1000;
+    for (int step = 0; step < MAX_STEPS; ++step) {
+        auto busiest = max_element(windows.begin(), windows.end(), [](const Window& a, const Window& b) {
+            return a.total_time < b.total_time;
+        });
+        bool improved = false;
 
-    while (!q.empty()) {
-        Visitor visitor = q.front();
-        q.pop();
+        for (size_t i = 0; i < busiest->visitors.size() && !improved; ++i) {
+            int duration = busiest->visitors[i].duration;
+            for (Window& other : windows) {
+                if (&other == &*busiest || other.total_time + duration >= busiest->total_time) continue;
+                other.total_time += duration;
+                busiest->total_time -= duration;
+                other.visitors.push_back(move(busiest->visitors[i]));
+                busiest->visitors.erase(busiest->visitors.begin() + i);
+                improved = true;
+                break;
+            }
+        }
 
-        auto min_window = min_element(windows.begin(), windows.end(),
-            [](const Window& a, const Window& b) {
-                return a.total_time < b.total_time;
-            });
+        for (size_t i = 0; i < busiest->visitors.size() && !improved; ++i) {
+            int a = busiest->visitors[i].duration;
+            for (Window& other : windows) {
+                if (&other == &*busiest || improved) continue;
+                for (Visitor& visitor : other.visitors) {
+                    int b = visitor.duration;
+                    if (b >= a || other.total_time - b + a >= busiest->total_time) continue;
+                    swap(busiest->visitors[i], visitor);
+                    busiest->total_time += b - a;
+                    other.total_time += a - b;
+                    improved = true;
+                    break;
+                }
+            }
+        }
 
-        min_window->visitors.push_back(visitor);
-        min_window->total_time += visitor.duration;
+        if (!improved) return;
     }
-    return windows;
 }
 
-int main() {
-    int windows_count = 0;
-    string command;
-    queue<Visitor> visitors_queue;
-    
-    while (true) {
-        cout << ">>> Введите кол-во окон" << endl;
-        cout << "<<< ";
-        try {
-            cin >> windows_count;
-            if (cin.fail() || windows_count <= 0) {
-                cin.clear();
-                cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                throw invalid_argument("Неверный ввод. Введите положительное целое число");
+// Точное распределение методом ветвей и границ; применяется только к небольшим входам
+const size_t EXACT_LIMIT = 20;
+
+class ExactPlanner {
+private:
+    vector<int> durations;
+    vector<int> order;
+    vector<int> loads;
+    vector<int> assignment;
+    vector<int> best_assignment;
+    int best;
+    int lower_bound;
+
+    void search(size_t k, int current) {
+        if (current >= best) return;
+        if (k == order.size()) {
+            best = current;
+            best_assignment = assignment;
+            return;
+        }
+        if (max(current, lower_bound) >= best) return;
+
+        int duration = durations[order[k]];
+        for (size_t w = 0; w < loads.size(); ++w) {
+            // Окна с одинаковой загрузкой взаимозаменяемы - достаточно попробовать первое
+            bool repeated = false;
+            for (size_t prev = 0; prev < w && !repeated; ++prev) {
+                repeated = loads[prev] == loads[w];
             }
-            break;
-        } catch (const exception& e) {
-            cerr << ">>> Ошибка: " << e.what() << endl;
+            if (repeated) continue;
+
+            loads[w] += duration;
+            assignment[order[k]] = static_cast<int>(w);
+            search(k + 1, max(current, loads[w]));
+            loads[w] -= duration;
+            if (best == lower_bound) return;
         }
     }
 
-    while (true) {
-        cout << "<<< ";
-        cin >> command;
-        
-        if (command == "ENQUEUE") {
-            while (true) {
-                int duration;
-                try {
-                    cin >> duration;
-                    if (cin.fail() || duration <= 0) {
-                        cin.clear();
-                        cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                        throw invalid_argument("Неверный ввод. Введите положительное целое число");
-                    }
-                    
-                    string ticket = generate_ticket();
-                    visitors_queue.push({ticket, duration});
-                    cout << ">>> " << ticket << endl;
-                    break;
-                } catch (const exception& e) {
-                    cerr << ">>> Ошибка: " << e.what() << endl;
-                }
+public:
+    vector<Window> solve(const vector<Visitor>& visitors, int windows_count, const vector<Window>& initial) {
+        durations.clear();
+        long long total = 0;
+        for (const Visitor& visitor : visitors) {
+            durations.push_back(visitor.duration);
+            total += visitor.duration;
+        }
+        order.resize(visitors.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = static_cast<int>(i);
+        stable_sort(order.begin(), order.end(), [this](int a, int b) { return durations[a] > durations[b]; });
+
+        loads.assign(windows_count, 0);
+        assignment.assign(visitors.size(), 0);
+        best = makespan(initial) + 1;
+        lower_bound = static_cast<int>((total + windows_count - 1) / windows_count);
+        if (!durations.empty()) lower_bound = max(lower_bound, durations[order[0]]);
+        search(0, 0);
+
+        vector<Window> windows(windows_count);
+        for (size_t i = 0; i < visitors.size(); ++i) {
+            Window& window = windows[best_assignment[i]];
+            window.total_time += visitors[i].duration;
+            window.visitors.push_back(visitors[i]);
+        }
+        return windows;
+    }
+};
+
+// Электронная очередь в реальном времени: посетитель получает окно в момент
+// постановки в очередь. Открытые окна упорядочены по времени освобождения
+// (а при равенстве - по номеру), поэтому выбор окна стоит O(log W)
+class QueueEngine {
+private:
+    struct Ticket {
+        Visitor visitor;
+        int window;
+        long long start;  // время начала обслуживания
+    };
+
+    struct ServiceWindow {
+        bool open = true;
+        long long busy_until = 0;
+        int total_time = 0;
+        vector<int> tickets;  // талоны в порядке обслуживания
+    };
+
+    long long now = 0;
+    vector<Ticket> tickets;
+    vector<ServiceWindow> windows;
+    set<pair<long long, int>> load;
+
+    void assign(int ticket) {
+        int index = load.begin()->second;
+        load.erase(load.begin());
+
+        ServiceWindow& window = windows[index];
+        tickets[ticket].window = index;
+        tickets[ticket].start = window.busy_until;
+        window.busy_until += tickets[ticket].visitor.duration;
+        window.total_time += tickets[ticket].visitor.duration;
+        window.tickets.push_back(ticket);
+
+        load.insert({window.busy_until, index});
+    }
+
+public:
+    explicit QueueEngine(int windows_count) : windows(windows_count) {
+        for (int i = 0; i < windows_count; ++i) {
+            load.insert({0, i});
+        }
+    }
+
+    long long time() const {
+        return now;
+    }
+
+    bool hasOpenWindows() const {
+        return !load.empty();
+    }
+
+    int openWindows() const {
+        return static_cast<int>(load.size());
+    }
+
+    vector<Visitor> visitors() const {
+        vector<Visitor> result;
+        result.reserve(tickets.size());
+        for (const Ticket& ticket : tickets) {
+            result.push_back(ticket.visitor);
+        }
+        return result;
+    }
+
+    const string& enqueue(int duration) {
+        tickets.push_back({{generate_ticket(), duration}, -1, 0});
+        assign(static_cast<int>(tickets.size()) - 1);
+        return tickets.back().visitor.ticket;
+    }
+
+    // Сдвиг времени: окна, успевшие освободиться, становятся свободными с момента now
+    void advance(int minutes) {
+        now += minutes;
+        while (!load.empty() && load.begin()->first < now) {
+            int index = load.begin()->second;
+            load.erase(load.begin());
+            windows[index].busy_until = now;
+            load.insert({now, index});
+        }
+    }
+
+    // Открывает закрытое окно number или, при number == 0, новое окно; возвращает его номер
+    int open(int number) {
+        int index;
+        if (number == 0) {
+            index = static_cast<int>(windows.size());
+            windows.emplace_back();
+        } else {
+            index = number - 1;
+            if (index < 0 || index >= static_cast<int>(windows.size()) || windows[index].open) return -1;
+            windows[index].open = true;
+        }
+        // Окно, закрытое во время обслуживания, освобождается не раньше конца этого обслуживания
+        windows[index].busy_until = max(now, windows[index].busy_until);
+        load.insert({windows[index].busy_until, index});
+        return index + 1;
+    }
+
+    // Закрывает окно: посетитель у окна дообслуживается, ожидающие переходят
+    // в другие окна. Возвращает число переназначенных посетителей или -1
+    int close(int number) {
+        int index = number - 1;
+        if (index < 0 || index >= static_cast<int>(windows.size()) || !windows[index].open) return -1;
+        if (load.size() == 1) return -1;
+
+        ServiceWindow& window = windows[index];
+        load.erase({window.busy_until, index});
+        window.open = false;
+
+        vector<int> waiting;
+        while (!window.tickets.empty() && tickets[window.tickets.back()].start >= now) {
+            waiting.push_back(window.tickets.back());
+            window.total_time -= tickets[window.tickets.back()].visitor.duration;
+            window.tickets.pop_back();
+        }
+        window.busy_until = window.tickets.empty() ? now
+            : max(now, tickets[window.tickets.back()].start + tickets[window.tickets.back()].visitor.duration);
+
+        for (auto it = waiting.rbegin(); it != waiting.rend(); ++it) {
+            assign(*it);
+        }
+        return static_cast<int>(waiting.size());
+    }
+
+    // Номер талона по его имени вида T001 или -1
+    int find(string_view name) const {
+        if (name.size() < 2 || name[0] != 'T') return -1;
+        Tokenizer number(name.substr(1));
+        int value;
+        if (!number.nextInt(value) || value < 1 || value > static_cast<int>(tickets.size())) return -1;
+        return value - 1;
+    }
+
+    void status(int ticket) const {
+        const Ticket& t = tickets[ticket];
+        out << ">>> " << t.visitor.ticket << ": ";
+        if (now >= t.start + t.visitor.duration) {
+            out << "обслужен в окне " << t.window + 1 << '\n';
+        } else if (now > t.start) {
+            out << "обслуживается в окне " << t.window + 1 << '\n';
+        } else {
+            out << "окно " << t.window + 1 << ", ожидание " << t.start - now << " минут" << '\n';
+        }
+    }
+
+    void print() const {
+        for (size_t i = 0; i < windows.size(); ++i) {
+            out << ">>> Окно " << i + 1 << " (";
+            if (!windows[i].open) out << "закрыто, ";
+            out << windows[i].total_time << " минут): ";
+            for (size_t j = 0; j < windows[i].tickets.size(); ++j) {
+                if (j != 0) out << ", ";
+                out << tickets[windows[i].tickets[j]].visitor.ticket;
             }
-        } 
-        else if (command == "DISTRIBUTE") {
-            break;
-        } 
-        else {
-            cout << ">>> Неизвестная команда. Используйте ENQUEUE или DISTRIBUTE" << endl;
-            cin.clear();
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+            out << '\n';
+        }
+    }
+};
+
+void report_error(const char* message) {
+    out.flush();
+    cerr << ">>> Ошибка: " << message << endl;
+}
+
+// Стратегии распределения для команды PLAN. GREEDY - распределение по порядку
+// прихода (как у DISTRIBUTE), LPT - сначала долгие посетители, REFINE - LPT с
+// локальным улучшением, EXACT - оптимум для не более EXACT_LIMIT посетителей
+enum class Strategy {
+    GREEDY,
+    LPT,
+    REFINE,
+    EXACT
+};
+
+const char* strategy_name(Strategy strategy) {
+    switch (strategy) {
+        case Strategy::GREEDY: return "GREEDY";
+        case Strategy::LPT: return "LPT";
+        case Strategy::REFINE: return "REFINE";
+        case Strategy::EXACT: return "EXACT";
+    }
+    return "";
+}
+
+vector<Window> plan(Strategy strategy, const vector<Visitor>& visitors, int windows_count) {
+    switch (strategy) {
+        case Strategy::GREEDY: {
+            queue<Visitor> q;
+            for (const Visitor& visitor : visitors) q.push(visitor);
+            return distribute_queue(q, windows_count);
+        }
+        case Strategy::LPT:
+            return distribute_lpt(visitors, windows_count);
+        case Strategy::REFINE: {
+            vector<Window> windows = distribute_lpt(visitors, windows_count);
+            refine(windows);
+            return windows;
+        }
+        case Strategy::EXACT: {
+            vector<Window> initial = distribute_lpt(visitors, windows_count);
+            refine(initial);
+            return ExactPlanner().solve(visitors, windows_count, initial);
         }
     }
+    return {};
+}
 
-    vector<Window> windows = distribute_queue(visitors_queue, windows_count);
+// Строит план выбранной стратегией и печатает загрузку и время расчёта
+void report_plan(Strategy strategy, const vector<Visitor>& visitors, int windows_count, bool details) {
+    out << ">>> " << strategy_name(strategy) << ": ";
+    if (strategy == Strategy::EXACT && visitors.size() > EXACT_LIMIT) {
+        out << "недоступно для более чем " << EXACT_LIMIT << " посетителей" << '\n';
+        return;
+    }
 
+    auto started = chrono::steady_clock::now();
+    vector<Window> windows = plan(strategy, visitors, windows_count);
+    auto elapsed = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - started);
+
+    out << "максимальная загрузка " << makespan(windows) << " минут, расчёт " << elapsed.count() << " мкс" << '\n';
+    if (!details) return;
     for (size_t i = 0; i < windows.size(); ++i) {
-        cout << ">>> Окно " << i + 1 << " (" << windows[i].total_time << " минут): ";
+        out << ">>> Окно " << i + 1 << " (" << windows[i].total_time << " минут): ";
         for (size_t j = 0; j < windows[i].visitors.size(); ++j) {
-            if (j != 0) cout << ", ";
-            cout << windows[i].visitors[j].ticket;
+            if (j != 0) out << ", ";
+            out << windows[i].visitors[j].ticket;
+        }
+        out << '\n';
+    }
+}
+
+// Режим моделирования (--simulate): подбор числа окон по случайным дням.
+// Ключи: --windows <от>-<до>, --days <дней>, --visitors <посетителей в день>,
+// --mean <средняя длительность>, --distribution exp|uniform, --seed <зерно>, --threads <потоков>
+int run_simulation(int argc, char* argv[]) {
+    SimulationConfig config;
+    for (int i = 1; i < argc; ++i) {
+        string_view option = argv[i];
+        // Общие ключи вывода и статистики разбирают configureOutput и configureStats
+        if (option == "--simulate" || option == "--no-stats" || option == "--batch" || option == "--interactive") continue;
+        if (option == "--stats-sample" || option == "--stats-file" || option == "--stats-interval" || option == "--prompt") {
+            ++i;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            report_error("Не указано значение ключа моделирования");
+            return 1;
+        }
+        string_view value = argv[++i];
+        int number = 0;
+        bool valid = true;
+        if (option == "--windows") {
+            size_t dash = value.find('-');
+            valid = Tokenizer(value.substr(0, dash)).nextInt(config.windows_from);
+            config.windows_to = config.windows_from;
+            if (valid && dash != string_view::npos) valid = Tokenizer(value.substr(dash + 1)).nextInt(config.windows_to);
+            valid = valid && config.windows_from > 0 && config.windows_to >= config.windows_from;
+        } else if (option == "--days") {
+            valid = Tokenizer(value).nextInt(config.days) && config.days > 0;
+        } else if (option == "--visitors") {
+            valid = Tokenizer(value).nextInt(config.visitors) && config.visitors > 0;
+        } else if (option == "--mean") {
+            char* end = nullptr;
+            config.mean = strtod(argv[i], &end);
+            valid = !value.empty() && *end == '\0' && config.mean >= 1 && config.mean <= 1e6;
+        } else if (option == "--distribution") {
+            valid = value == "exp" || value == "uniform";
+            config.distribution = value == "uniform" ? Distribution::UNIFORM : Distribution::EXPONENTIAL;
+        } else if (option == "--seed") {
+            char* end = nullptr;
+            errno = 0;
+            config.seed = strtoull(argv[i], &end, 10);
+            valid = !value.empty() && isdigit(static_cast<unsigned char>(value[0])) && *end == '\0' && errno == 0;
+        } else if (option == "--threads") {
+            valid = Tokenizer(value).nextInt(number) && number > 0;
+            config.threads = static_cast<size_t>(number);
+        } else {
+            valid = false;
+        }
+        if (!valid) {
+            report_error("Используйте: --simulate [--windows <от>-<до>] [--days N] [--visitors N] [--mean M] "
+                         "[--distribution exp|uniform] [--seed S] [--threads T]");
+            return 1;
+        }
+    }
+
+    out << ">>> Моделирование: " << config.days << " дней по " << config.visitors << " посетителей, "
+        << "среднее обслуживание " << Fixed{config.mean, 1} << " минут ("
+        << (config.distribution == Distribution::UNIFORM ? "uniform" : "exp") << "), окна "
+        << config.windows_from << "-" << config.windows_to << ", потоков " << config.threads << '\n';
+
+    auto started = chrono::steady_clock::now();
+    vector<WindowsResult> results = simulate_queue(config);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+    // Загрузка и ожидание в минутах, использование - доля времени работы окон
+    out << ">>> windows makespan_avg makespan_p50 makespan_p95 utilization wait_p50 wait_p90 wait_p99" << '\n';
+    for (const WindowsResult& result : results) {
+        out << ">>> " << result.windows << ' ' << Fixed{result.average_makespan(), 1} << ' '
+            << result.makespan_percentile(0.5) << ' ' << result.makespan_percentile(0.95) << ' '
+            << Fixed{result.utilization(), 3} << ' ' << result.waits.percentile(0.5) << ' '
+            << result.waits.percentile(0.9) << ' ' << result.waits.percentile(0.99) << '\n';
+    }
+    double days = static_cast<double>(config.days) * static_cast<double>(results.size());
+    out << ">>> Расчёт " << Fixed{seconds * 1000, 1} << " мс: " << Fixed{days / seconds, 0} << " дней и "
+        << Fixed{days * config.visitors / seconds / 1e6, 2} << " млн посетителей в секунду" << '\n';
+    return 0;
+}
+
+enum class Command {
+    ENQUEUE,
+    DISTRIBUTE,
+    STATUS,
+    ADVANCE,
+    OPEN,
+    CLOSE,
+    PLAN,
+    STATS,
+    EXIT,
+    UNKNOWN
+};
+
+Command parseCommand(string_view word) {
+    switch (commandHash(word)) {
+        case commandHash("ENQUEUE"): if (word == "ENQUEUE") return Command::ENQUEUE; break;
+        case commandHash("DISTRIBUTE"): if (word == "DISTRIBUTE") return Command::DISTRIBUTE; break;
+        case commandHash("STATUS"): if (word == "STATUS") return Command::STATUS; break;
+        case commandHash("ADVANCE"): if (word == "ADVANCE") return Command::ADVANCE; break;
+        case commandHash("OPEN"): if (word == "OPEN") return Command::OPEN; break;
+        case commandHash("CLOSE"): if (word == "CLOSE") return Command::CLOSE; break;
+        case commandHash("PLAN"): if (word == "PLAN") return Command::PLAN; break;
+        case commandHash("STATS"): if (word == "STATS") return Command::STATS; break;
+        case commandHash("EXIT"): if (word == "EXIT") return Command::EXIT; break;
+    }
+    return Command::UNKNOWN;
+}
+
+int main(int argc, char* argv[]) {
+    ios::sync_with_stdio(false);
+    configureOutput(argc, argv);
+    configureStats(argc, argv);
+    stats.setCommands({"ENQUEUE", "DISTRIBUTE", "STATUS", "ADVANCE", "OPEN", "CLOSE", "PLAN", "STATS", "EXIT"});
+    for (int i = 1; i < argc; ++i) {
+        if (string_view(argv[i]) == "--simulate") return run_simulation(argc, argv);
+    }
+
+    int windows_count = 0;
+    string line;
+    
+    while (true) {
+        out << ">>> Введите кол-во окон" << '\n';
+        out << "<<< ";
+        out.flushIfInteractive();
+        if (!readLine(cin, line)) return 0;
+        Tokenizer tokens(line);
+        if (!tokens.nextInt(windows_count) || windows_count <= 0 || !tokens.empty()) {
+            report_error("Неверный ввод. Введите положительное целое число");
+            continue;
+        }
+        break;
+    }
+
+    QueueEngine engine(windows_count);
+    bool running = true;
+    while (running) {
+        stats.tick();
+        out << "<<< ";
+        out.flushIfInteractive();
+        if (!readLine(cin, line)) break;
+        StatTimer timer;
+        Tokenizer tokens(line);
+        if (tokens.empty()) continue;
+
+        int number;
+        Command cmd = parseCommand(tokens.next());
+        timer.command(static_cast<int>(cmd));
+        switch (cmd) {
+            case Command::ENQUEUE:
+                if (!tokens.nextInt(number) || number <= 0 || !tokens.empty()) {
+                    report_error("Неверный ввод. Введите положительное целое число");
+                    break;
+                }
+                statPhase(Phase::VALIDATE);
+                if (!engine.hasOpenWindows()) {
+                    report_error("Нет открытых окон");
+                    break;
+                }
+                {
+                    statPhase(Phase::APPLY);
+                    const string& ticket = engine.enqueue(number);
+                    statPhase(Phase::PRINT);
+                    out << ">>> " << ticket << '\n';
+                }
+                break;
+            case Command::STATUS: {
+                string_view name = tokens.next();
+                statPhase(Phase::VALIDATE);
+                int ticket = engine.find(name);
+                if (ticket < 0 || !tokens.empty()) {
+                    report_error("Талон не найден. Используйте: STATUS <талон>");
+                    break;
+                }
+                statPhase(Phase::APPLY);
+                engine.status(ticket);
+                break;
+            }
+            case Command::ADVANCE:
+                if (!tokens.nextInt(number) || number < 0 || !tokens.empty()) {
+                    report_error("Неверный ввод. Введите неотрицательное число минут");
+                    break;
+                }
+                statPhase(Phase::APPLY);
+                engine.advance(number);
+                statPhase(Phase::PRINT);
+                out << ">>> Текущее время: " << engine.time() << " минут" << '\n';
+                break;
+            case Command::OPEN: {
+                number = 0;
+                if (!tokens.empty() && (!tokens.nextInt(number) || !tokens.empty())) {
+                    report_error("Неверный номер окна. Используйте: OPEN [<номер закрытого окна>]");
+                    break;
+                }
+                statPhase(Phase::APPLY);
+                int opened = engine.open(number);
+                statPhase(Phase::PRINT);
+                if (opened < 0) {
+                    report_error("Окно не существует или уже открыто");
+                    break;
+                }
+                out << ">>> Открыто окно " << opened << '\n';
+                break;
+            }
+            case Command::CLOSE: {
+                if (!tokens.nextInt(number) || !tokens.empty()) {
+                    report_error("Неверный номер окна. Используйте: CLOSE <номер окна>");
+                    break;
+                }
+                statPhase(Phase::APPLY);
+                int moved = engine.close(number);
+                statPhase(Phase::PRINT);
+                if (moved < 0) {
+                    report_error("Окно не существует, уже закрыто или является последним открытым");
+                    break;
+                }
+                out << ">>> Окно " << number << " закрыто, переназначено посетителей: " << moved << '\n';
+                break;
+            }
+            case Command::DISTRIBUTE:
+                statPhase(Phase::PRINT);
+                engine.print();
+                break;
+            case Command::PLAN: {
+                // PLAN без аргумента сравнивает все стратегии, PLAN <стратегия> печатает план
+                string_view name = tokens.next();
+                const Strategy all[] = {Strategy::GREEDY, Strategy::LPT, Strategy::REFINE, Strategy::EXACT};
+                if (!engine.hasOpenWindows() || !tokens.empty()) {
+                    report_error("Используйте: PLAN [GREEDY|LPT|REFINE|EXACT] при открытых окнах");
+                    break;
+                }
+                statPhase(Phase::APPLY);
+                vector<Visitor> visitors = engine.visitors();
+                bool found = name.empty();
+                for (Strategy strategy : all) {
+                    if (name.empty() || name == strategy_name(strategy)) {
+                        report_plan(strategy, visitors, engine.openWindows(), !name.empty());
+                        found = true;
+                    }
+                }
+                if (!found) report_error("Неизвестная стратегия. Используйте GREEDY, LPT, REFINE или EXACT");
+                break;
+            }
+            case Command::STATS: {
+                // STATS [ON|OFF|RESET]
+                string_view argument = tokens.next();
+                if (!tokens.empty() || !statsCommand(argument, out)) {
+                    report_error("Используйте: STATS [ON|OFF|RESET]");
+                }
+                break;
+            }
+            case Command::EXIT:
+                running = false;
+                break;
+            case Command::UNKNOWN:
+                out << ">>> Неизвестная команда. Используйте ENQUEUE, STATUS, ADVANCE, OPEN, CLOSE, DISTRIBUTE, PLAN, STATS или EXIT" << '\n';
+                break;
         }
-        cout << endl;
     }
     return 0;
 }
@@ -1,58 +1,211 @@
 #include <iostream>
 #include <vector>
 #include <string>
-#include <sstream>
+#include <stdexcept>
 #include "trolley.h"
+#include "tokenizer.h"
+#include "output.h"
+#include "stats.h"
 using namespace std;
 
-vector<string> split(const string& s) {
-    vector<string> result;
-    istringstream iss(s);
-    string token;
-    while (iss >> token) {
-        result.push_back(token);
+void loadSnapshot(TrolleySystem& system, const string& path) {
+    if (system.load(path)) {
+        out << "Loaded " << path << ": " << system.trolleyCount() << " trolleys, "
+            << system.stopCount() << " stops" << '\n';
+    } else {
+        out << "Cannot load snapshot " << path << '\n';
     }
-    return result;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    ios::sync_with_stdio(false);
+    configureOutput(argc, argv);
+    configureStats(argc, argv);
+    stats.setCommands({"CREATE_TRL", "TRL_IN_STOP", "STOPS_IN_TRL", "TRLS", "UPDATE_TRL", "DELETE_TRL", "ROUTE",
+                       "SCHEDULE", "DEPART", "NEXT", "ARRIVE", "SAVE", "LOAD", "STATS"});
     TrolleySystem system;
     string line;
+    vector<string_view> stops;
+    vector<int> minutes;
 
-    while (getline(cin, line)) {
-        if (line.empty()) continue;
+    // --load <файл> начинает работу со снимка сети, сохранённого командой SAVE
+    for (int i = 1; i < argc; ++i) {
+        if (string(argv[i]) == "--load" && i + 1 < argc) {
+            loadSnapshot(system, argv[++i]);
+        }
+    }
 
-        vector<string> tokens = split(line);
+    while (true) {
+        stats.tick();
+        out.promptInput();
+        if (!readLine(cin, line)) break;
+        StatTimer timer;
+        Tokenizer tokens(line);
         if (tokens.empty()) continue;
 
         try {
-            CommandType cmd = parseCommand(tokens[0]);
+            CommandType cmd = parseCommand(tokens.next());
+            timer.command(static_cast<int>(cmd));
 
             switch (cmd) {
-                case CommandType::CREATE_TRL: {
-                    if (tokens.size() < 3) {
-                        cout << "Invalid command format" << endl;
+                case CommandType::CREATE_TRL:
+                case CommandType::UPDATE_TRL: {
+                    string_view trolley = tokens.next();
+                    stops.clear();
+                    while (!tokens.empty()) {
+                        stops.push_back(tokens.next());
+                    }
+                    if (stops.empty()) {
+                        out << "Invalid command format" << '\n';
                         break;
                     }
-                    string name = tokens[1];
-                    vector<string> stops(tokens.begin() + 2, tokens.end());
-                    system.createTrolley(name, stops);
+                    if (cmd == CommandType::CREATE_TRL) {
+                        statPhase(Phase::APPLY);
+                        system.createTrolley(trolley, stops);
+                    } else if (!system.updateTrolley(trolley, stops)) {
+                        out << "Trolley " << trolley << " is absent" << '\n';
+                    }
                     break;
                 }
                 case CommandType::TRL_IN_STOP: {
-                    if (tokens.size() != 2) {
-                        cout << "Invalid command format" << endl;
+                    string_view name = tokens.next();
+                    if (name.empty() || !tokens.empty()) {
+                        out << "Invalid command format" << '\n';
                         break;
                     }
-                    system.trolleysForStop(tokens[1]);
+                    system.trolleysForStop(name);
                     break;
                 }
                 case CommandType::STOPS_IN_TRL: {
-                    if (tokens.size() != 2) {
-                        cout << "Invalid command format" << endl;
+                    string_view name = tokens.next();
+                    if (name.empty() || !tokens.empty()) {
+                        out << "Invalid command format" << '\n';
+                        break;
+                    }
+                    system.stopsForTrolley(name);
+                    break;
+                }
+                case CommandType::DELETE_TRL: {
+                    string_view name = tokens.next();
+                    if (name.empty() || !tokens.empty()) {
+                        out << "Invalid command format" << '\n';
                         break;
                     }
-                    system.stopsForTrolley(tokens[1]);
+                    if (!system.deleteTrolley(name)) {
+                        out << "Trolley " << name << " is absent" << '\n';
+                    }
+                    break;
+                }
+                case CommandType::ROUTE: {
+                    string_view from = tokens.next();
+                    string_view to = tokens.next();
+                    if (to.empty() || !tokens.empty()) {
+                        out << "Invalid command format" << '\n';
+                        break;
+                    }
+                    system.route(from, to);
+                    break;
+                }
+                case CommandType::SCHEDULE: {
+                    string_view trolley = tokens.next();
+                    minutes.clear();
+                    int segment;
+                    long long total = 0;
+                    bool valid = !trolley.empty();
+                    while (valid && !tokens.empty()) {
+                        valid = tokens.nextInt(segment) && segment > 0;
+                        minutes.push_back(segment);
+                        total += segment;
+                    }
+                    statPhase(Phase::VALIDATE);
+                    if (!valid || minutes.empty()) {
+                        out << "Invalid command format" << '\n';
+                    } else if (total >= MAX_SCHEDULE_MINUTES) {
+                        out << "Schedule of " << trolley << " is longer than " << MAX_SCHEDULE_MINUTES << " minutes" << '\n';
+                    } else if (!system.isTrolleyExist(trolley)) {
+                        out << "Trolley " << trolley << " is absent" << '\n';
+                    } else if (!system.setSegmentTimes(trolley, minutes)) {
+                        out << "Schedule of " << trolley << " does not match its stops" << '\n';
+                    }
+                    break;
+                }
+                case CommandType::DEPART: {
+                    // DEPART <trl> <first> <last> <headway> или DEPART <trl> <time> ...
+                    string_view trolley = tokens.next();
+                    minutes.clear();
+                    int time;
+                    int headway = 0;
+                    bool isHeadway = false;
+                    bool valid = !trolley.empty() && !tokens.empty();
+                    while (valid && !tokens.empty()) {
+                        string_view token = tokens.next();
+                        // Третье и последнее число без двоеточия - интервал в минутах
+                        if (minutes.size() == 2 && tokens.empty() && token.find(':') == string_view::npos) {
+                            isHeadway = true;
+                            valid = Tokenizer(token).nextInt(headway) && headway > 0;
+                            break;
+                        }
+                        valid = parseTime(token, time);
+                        minutes.push_back(time);
+                    }
+                    statPhase(Phase::VALIDATE);
+                    if (!valid) {
+                        out << "Invalid command format" << '\n';
+                    } else if (!system.isTrolleyExist(trolley)) {
+                        out << "Trolley " << trolley << " is absent" << '\n';
+                    } else if (isHeadway) {
+                        if (!system.addDepartures(trolley, minutes[0], minutes[1], headway)) {
+                            out << "Invalid command format" << '\n';
+                        }
+                    } else if (!system.addDepartures(trolley, minutes)) {
+                        out << "Invalid command format" << '\n';
+                    }
+                    break;
+                }
+                case CommandType::NEXT: {
+                    string_view stop = tokens.next();
+                    int time;
+                    if (stop.empty() || !parseTime(tokens.next(), time) || !tokens.empty()) {
+                        out << "Invalid command format" << '\n';
+                        break;
+                    }
+                    system.nextDepartures(stop, time);
+                    break;
+                }
+                case CommandType::ARRIVE: {
+                    string_view from = tokens.next();
+                    string_view to = tokens.next();
+                    int time;
+                    if (to.empty() || !parseTime(tokens.next(), time) || !tokens.empty()) {
+                        out << "Invalid command format" << '\n';
+                        break;
+                    }
+                    system.arrive(from, to, time);
+                    break;
+                }
+                case CommandType::SAVE:
+                case CommandType::LOAD: {
+                    string path(tokens.next());
+                    if (path.empty() || !tokens.empty()) {
+                        out << "Invalid command format" << '\n';
+                        break;
+                    }
+                    if (cmd == CommandType::LOAD) {
+                        loadSnapshot(system, path);
+                    } else if (system.save(path)) {
+                        out << "Saved " << path << ": " << system.trolleyCount() << " trolleys, "
+                            << system.stopCount() << " stops" << '\n';
+                    } else {
+                        out << "Cannot save snapshot " << path << '\n';
+                    }
+                    break;
+                }
+                case CommandType::STATS: {
+                    // STATS [ON|OFF|RESET]
+                    string_view argument = tokens.next();
+                    if (!tokens.empty() || !statsCommand(argument, out)) {
+                        out << "Invalid command format" << '\n';
+                    }
                     break;
                 }
                 case CommandType::TRLS: {
@@ -61,7 +214,7 @@ int main() {
                 }
             }
         } catch (const invalid_argument& e) {
-            cout << "Error: " << e.what() << endl;
+            out << "Error: " << e.what() << '\n';
         }
     }
     return 0;
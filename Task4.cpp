@@ -1,105 +1,461 @@
 #include <iostream>
 #include <vector>
-#include <set>
+#include <climits>
+#include <cstdint>
 #include <algorithm>
-#include <limits>
+#include <string>
+#include <string_view>
+#include "tokenizer.h"
+#include "output.h"
+#include "journal.h"
+#include "stats.h"
 using namespace std;
 
+// Множество студентов 1..n в виде битов: студент k - бит k-1.
+// Биты за пределами текущего числа студентов всегда нулевые.
+// Число единиц в блоках по 8 слов хранится в дереве Фенвика,
+// поэтому k-й элемент множества находится за O(log n)
+class StudentBitset {
+private:
+    static constexpr size_t BLOCK_WORDS = 8;
+
+    vector<uint64_t> words;
+    vector<int> tree;
+    size_t ones = 0;
+
+    void addToBlock(size_t word, int delta) {
+        for (size_t i = word / BLOCK_WORDS + 1; i < tree.size(); i += i & (~i + 1)) {
+            tree[i] += delta;
+        }
+    }
+
+    void rebuildTree() {
+        size_t blocks = words.size() / BLOCK_WORDS;
+        tree.assign(blocks + 1, 0);
+        for (size_t word = 0; word < words.size(); ++word) {
+            tree[word / BLOCK_WORDS + 1] += __builtin_popcountll(words[word]);
+        }
+        for (size_t i = 1; i <= blocks; ++i) {
+            size_t parent = i + (i & (~i + 1));
+            if (parent <= blocks) tree[parent] += tree[i];
+        }
+    }
+
+public:
+    bool test(int student) const {
+        size_t bit = static_cast<size_t>(student - 1);
+        return (words[bit >> 6] >> (bit & 63)) & 1;
+    }
+
+    void set(int student) {
+        size_t bit = static_cast<size_t>(student - 1);
+        uint64_t mask = uint64_t(1) << (bit & 63);
+        if (!(words[bit >> 6] & mask)) {
+            words[bit >> 6] |= mask;
+            addToBlock(bit >> 6, 1);
+            ++ones;
+        }
+    }
+
+    void reset(int student) {
+        size_t bit = static_cast<size_t>(student - 1);
+        uint64_t mask = uint64_t(1) << (bit & 63);
+        if (words[bit >> 6] & mask) {
+            words[bit >> 6] &= ~mask;
+            addToBlock(bit >> 6, -1);
+            --ones;
+        }
+    }
+
+    // Место под студентов 1..n; новые биты нулевые
+    void grow(int n) {
+        size_t needed = (static_cast<size_t>(n) + 64 * BLOCK_WORDS - 1) / (64 * BLOCK_WORDS) * BLOCK_WORDS;
+        if (words.size() < needed) {
+            words.resize(max(needed, words.size() * 2), 0);
+            rebuildTree();
+        }
+    }
+
+    // Сбрасывает биты студентов from..to пословно
+    void clearRange(int from, int to) {
+        size_t first = static_cast<size_t>(from - 1);
+        size_t last = static_cast<size_t>(to);
+        while (first < last) {
+            size_t word = first >> 6;
+            size_t end = min(last, (word + 1) * 64);
+            uint64_t mask = ~uint64_t(0) << (first & 63);
+            if (end - word * 64 < 64) mask &= (uint64_t(1) << (end - word * 64)) - 1;
+            int cleared = __builtin_popcountll(words[word] & mask);
+            if (cleared > 0) {
+                words[word] &= ~mask;
+                addToBlock(word, -cleared);
+                ones -= static_cast<size_t>(cleared);
+            }
+            first = end;
+        }
+    }
+
+    size_t count() const {
+        return ones;
+    }
+
+    // k-й по возрастанию элемент множества, k от 1 до count()
+    int select(size_t k) const {
+        size_t blocks = tree.size() - 1;
+        size_t block = 0;
+        size_t step = 1;
+        while (step * 2 <= blocks) step *= 2;
+        for (; step > 0; step /= 2) {
+            if (block + step <= blocks && static_cast<size_t>(tree[block + step]) < k) {
+                block += step;
+                k -= static_cast<size_t>(tree[block]);
+            }
+        }
+
+        size_t word = block * BLOCK_WORDS;
+        size_t ones_in_word;
+        while ((ones_in_word = static_cast<size_t>(__builtin_popcountll(words[word]))) < k) {
+            k -= ones_in_word;
+            ++word;
+        }
+        uint64_t bits = words[word];
+        while (--k > 0) bits &= bits - 1;
+        return static_cast<int>(word * 64 + __builtin_ctzll(bits)) + 1;
+    }
+
+    // Обход установленных битов по возрастанию, начиная со студента from;
+    // visit возвращает false, чтобы остановить обход
+    template <typename Visitor>
+    void forEach(int from, Visitor visit) const {
+        size_t bit = static_cast<size_t>(from - 1);
+        for (size_t word = bit >> 6; word < words.size(); ++word) {
+            uint64_t bits = words[word];
+            if (word == bit >> 6) bits &= ~uint64_t(0) << (bit & 63);
+            for (; bits; bits &= bits - 1) {
+                if (!visit(static_cast<int>(word * 64 + __builtin_ctzll(bits)) + 1)) return;
+            }
+        }
+    }
+};
+
+// Студенты всегда занимают номера 1..student_count, поэтому
+// принадлежность - это проверка границ, а флаги хранятся битами
 class StudentSystem {
 private:
-    vector<int> students;
-    set<int> suspicious_students;
-    set<int> immortal_students;
+    int student_count = 0;
+    StudentBitset suspicious_students;
+    StudentBitset immortal_students;
+
+    // Запись журнала отмены: изменение числа студентов или одного флага.
+    // Отчисление записывает сброшенные флаги отчисленных, чтобы UNDO их вернул
+    enum class ChangeKind {
+        COUNT,
+        SET_SUSPICIOUS,
+        RESET_SUSPICIOUS,
+        SET_IMMORTAL,
+        RESET_IMMORTAL
+    };
+
+    struct Change {
+        ChangeKind kind;
+        int value;  // для COUNT - на сколько изменилось число студентов, иначе номер студента
+    };
+
+    static constexpr size_t JOURNAL_RECORDS = 1 << 20;
+    Journal<Change> journal{JOURNAL_RECORDS};
+
+    bool isStudent(int student_number) const {
+        return student_number >= 1 && student_number <= student_count;
+    }
+
+    void apply(const Change& change) {
+        switch (change.kind) {
+            case ChangeKind::COUNT:
+                student_count += change.value;
+                suspicious_students.grow(student_count);
+                immortal_students.grow(student_count);
+                break;
+            case ChangeKind::SET_SUSPICIOUS: suspicious_students.set(change.value); break;
+            case ChangeKind::RESET_SUSPICIOUS: suspicious_students.reset(change.value); break;
+            case ChangeKind::SET_IMMORTAL: immortal_students.set(change.value); break;
+            case ChangeKind::RESET_IMMORTAL: immortal_students.reset(change.value); break;
+        }
+    }
+
+    void revert(const Change& change) {
+        switch (change.kind) {
+            case ChangeKind::COUNT:
+                apply({ChangeKind::COUNT, -change.value});
+                break;
+            case ChangeKind::SET_SUSPICIOUS: suspicious_students.reset(change.value); break;
+            case ChangeKind::RESET_SUSPICIOUS: suspicious_students.set(change.value); break;
+            case ChangeKind::SET_IMMORTAL: immortal_students.reset(change.value); break;
+            case ChangeKind::RESET_IMMORTAL: immortal_students.set(change.value); break;
+        }
+    }
 
 public:
     void addStudents(int number) {
+        statPhase(Phase::APPLY);
         if (number > 0) {
-            int start = students.empty() ? 1 : students.back() + 1;
-            for (int i = start; i < start + number; ++i) {
-                students.push_back(i);
+            // Номера студентов - int: больше INT_MAX студентов не поместится
+            if (static_cast<long long>(student_count) + number > INT_MAX) {
+                out << "Incorrect" << '\n';
+                return;
             }
-            cout << "Welcome " << number << " clever students!" << endl;
+            journal.begin();
+            journal.record({ChangeKind::COUNT, number});
+            journal.commit();
+            student_count += number;
+            suspicious_students.grow(student_count);
+            immortal_students.grow(student_count);
+            statPhase(Phase::PRINT);
+            out << "Welcome " << number << " clever students!" << '\n';
         } else if (number < 0) {
-            if (abs(number) > students.size()) {
-                cout << "Incorrect" << endl;
+            long long expelled = -static_cast<long long>(number);
+            if (expelled > student_count) {
+                out << "Incorrect" << '\n';
                 return;
             }
-            for (int i = 0; i < abs(number); ++i) {
-                int student = students.back();
-                students.pop_back();
-                suspicious_students.erase(student);
-                immortal_students.erase(student);
-            }
-            cout << "GoodBye " << abs(number) << " clever students!" << endl;
+            int first = student_count - static_cast<int>(expelled) + 1;
+            journal.begin();
+            suspicious_students.forEach(first, [this](int student) {
+                journal.record({ChangeKind::RESET_SUSPICIOUS, student});
+                return true;
+            });
+            immortal_students.forEach(first, [this](int student) {
+                journal.record({ChangeKind::RESET_IMMORTAL, student});
+                return true;
+            });
+            journal.record({ChangeKind::COUNT, -static_cast<int>(expelled)});
+            journal.commit();
+            suspicious_students.clearRange(first, student_count);
+            immortal_students.clearRange(first, student_count);
+            student_count = first - 1;
+            statPhase(Phase::PRINT);
+            out << "GoodBye " << expelled << " clever students!" << '\n';
         }
     }
 
     void suspicious(int student_number) {
-        if (find(students.begin(), students.end(), student_number) == students.end()) {
-            cout << "Incorrect" << endl;
+        statPhase(Phase::VALIDATE);
+        if (!isStudent(student_number)) {
+            out << "Incorrect" << '\n';
             return;
         }
-        if (immortal_students.count(student_number) == 0) {
-            suspicious_students.insert(student_number);
-            cout << "The suspected student " << student_number << endl;
+        statPhase(Phase::APPLY);
+        if (!immortal_students.test(student_number)) {
+            if (!suspicious_students.test(student_number)) {
+                journal.begin();
+                journal.record({ChangeKind::SET_SUSPICIOUS, student_number});
+                journal.commit();
+            }
+            suspicious_students.set(student_number);
+            statPhase(Phase::PRINT);
+            out << "The suspected student " << student_number << '\n';
         }
     }
 
     void immortal(int student_number) {
-        if (find(students.begin(), students.end(), student_number) == students.end()) {
-            cout << "Incorrect" << endl;
+        statPhase(Phase::VALIDATE);
+        if (!isStudent(student_number)) {
+            out << "Incorrect" << '\n';
+            return;
+        }
+        statPhase(Phase::APPLY);
+        bool was_immortal = immortal_students.test(student_number);
+        bool was_suspicious = suspicious_students.test(student_number);
+        if (!was_immortal || was_suspicious) {
+            journal.begin();
+            if (!was_immortal) journal.record({ChangeKind::SET_IMMORTAL, student_number});
+            if (was_suspicious) journal.record({ChangeKind::RESET_SUSPICIOUS, student_number});
+            journal.commit();
+        }
+        immortal_students.set(student_number);
+        suspicious_students.reset(student_number);
+        statPhase(Phase::PRINT);
+        out << "Student " << student_number << " is immortal!" << '\n';
+    }
+
+    // Отмена и повтор за время, пропорциональное числу изменений в операции
+    void undo() {
+        statPhase(Phase::APPLY);
+        if (journal.undo([this](const Change& change) { revert(change); }) == 0) {
+            out << "Incorrect" << '\n';
             return;
         }
-        immortal_students.insert(student_number);
-        suspicious_students.erase(student_number);
-        cout << "Student " << student_number << " is immortal!" << endl;
+        statPhase(Phase::PRINT);
+        out << "Undo done, " << student_count << " students" << '\n';
+    }
+
+    void redo() {
+        statPhase(Phase::APPLY);
+        if (journal.redo([this](const Change& change) { apply(change); }) == 0) {
+            out << "Incorrect" << '\n';
+            return;
+        }
+        statPhase(Phase::PRINT);
+        out << "Redo done, " << student_count << " students" << '\n';
+    }
+
+    // Страница списка на отчисление: limit студентов, начиная с offset (от нуля)
+    void topList(size_t offset, size_t limit) {
+        statPhase(Phase::PRINT);
+        out << "List of students for expulsion:";
+        if (offset < suspicious_students.count() && limit > 0) {
+            const char* separator = " Student ";
+            suspicious_students.forEach(suspicious_students.select(offset + 1), [&](int student) {
+                out << separator << student;
+                separator = ", Student ";
+                return --limit > 0;
+            });
+        }
+        out << '\n';
     }
 
     void topList() {
-        cout << "List of students for expulsion:";
-        bool first = true;
-        for (int student : suspicious_students) {
-            if (!first) cout << ",";
-            cout << " Student " << student;
-            first = false;
+        topList(0, suspicious_students.count());
+    }
+
+    void kthSuspicious(int k) {
+        statPhase(Phase::VALIDATE);
+        if (k < 1 || static_cast<size_t>(k) > suspicious_students.count()) {
+            out << "Incorrect" << '\n';
+            return;
         }
-        cout << endl;
+        statPhase(Phase::APPLY);
+        int student = suspicious_students.select(k);
+        statPhase(Phase::PRINT);
+        out << "Student " << student << " is number " << k << " for expulsion" << '\n';
     }
 
     void suspiciousCount() {
-        cout << "List of students for expulsion consists of " << suspicious_students.size() << " students" << endl;
+        statPhase(Phase::PRINT);
+        out << "List of students for expulsion consists of " << suspicious_students.count() << " students" << '\n';
     }
 };
 
-int main() {
+enum class Command {
+    NEW_STUDENTS,
+    SUSPICIOUS,
+    IMMORTIAL,
+    TOP_LIST,
+    SCOUNT,
+    KTH,
+    UNDO,
+    REDO,
+    STATS,
+    UNKNOWN
+};
+
+Command parseCommand(string_view word) {
+    switch (commandHash(word)) {
+        case commandHash("NEW_STUDENTS"): if (word == "NEW_STUDENTS") return Command::NEW_STUDENTS; break;
+        case commandHash("SUSPICIOUS"): if (word == "SUSPICIOUS") return Command::SUSPICIOUS; break;
+        case commandHash("IMMORTIAL"): if (word == "IMMORTIAL") return Command::IMMORTIAL; break;
+        case commandHash("TOP-LIST"): if (word == "TOP-LIST") return Command::TOP_LIST; break;
+        case commandHash("SCOUNT"): if (word == "SCOUNT") return Command::SCOUNT; break;
+        case commandHash("KTH"): if (word == "KTH") return Command::KTH; break;
+        case commandHash("UNDO"): if (word == "UNDO") return Command::UNDO; break;
+        case commandHash("REDO"): if (word == "REDO") return Command::REDO; break;
+        case commandHash("STATS"): if (word == "STATS") return Command::STATS; break;
+    }
+    return Command::UNKNOWN;
+}
+
+int main(int argc, char* argv[]) {
+    ios::sync_with_stdio(false);
+    configureOutput(argc, argv);
+    configureStats(argc, argv);
+    stats.setCommands({"NEW_STUDENTS", "SUSPICIOUS", "IMMORTIAL", "TOP-LIST", "SCOUNT", "KTH", "UNDO", "REDO", "STATS"});
     StudentSystem system;
-    int N;
-    cin >> N;
+    string line;
+    int N = 0;
+    while (true) {
+        out.promptInput();
+        if (!readLine(cin, line)) break;
+        Tokenizer tokens(line);
+        if (tokens.empty()) continue;
+        if (!tokens.nextInt(N)) N = 0;
+        break;
+    }
 
     for (int i = 0; i < N; ++i) {
-        string command;
-        cin >> command;
-
-        if (command == "NEW_STUDENTS") {
-            int number;
-            cin >> number;
-            system.addStudents(number);
-        } else if (command == "SUSPICIOUS") {
-            int student_number;
-            cin >> student_number;
-            system.suspicious(student_number);
-        } else if (command == "IMMORTIAL") {
-            int student_number;
-            cin >> student_number;
-            system.immortal(student_number);
-        } else if (command == "TOP-LIST") {
-            system.topList();
-        } else if (command == "SCOUNT") {
-            system.suspiciousCount();
-        } else {
-            cout << "Incorrect" << endl;
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        stats.tick();
+        out.promptInput();
+        if (!readLine(cin, line)) break;
+        StatTimer timer;
+        Tokenizer tokens(line);
+        if (tokens.empty()) {
+            --i;
+            continue;
+        }
+
+        int number;
+        Command cmd = parseCommand(tokens.next());
+        timer.command(static_cast<int>(cmd));
+        switch (cmd) {
+            case Command::NEW_STUDENTS:
+                if (tokens.nextInt(number)) {
+                    system.addStudents(number);
+                } else {
+                    out << "Incorrect" << '\n';
+                }
+                break;
+            case Command::SUSPICIOUS:
+                if (tokens.nextInt(number)) {
+                    system.suspicious(number);
+                } else {
+                    out << "Incorrect" << '\n';
+                }
+                break;
+            case Command::IMMORTIAL:
+                if (tokens.nextInt(number)) {
+                    system.immortal(number);
+                } else {
+                    out << "Incorrect" << '\n';
+                }
+                break;
+            case Command::TOP_LIST: {
+                // TOP-LIST - весь список, TOP-LIST <offset> <limit> - одна страница
+                int offset, limit;
+                if (tokens.empty()) {
+                    system.topList();
+                } else if (tokens.nextInt(offset) && tokens.nextInt(limit) && offset >= 0 && limit >= 0) {
+                    system.topList(offset, limit);
+                } else {
+                    out << "Incorrect" << '\n';
+                }
+                break;
+            }
+            case Command::KTH:
+                if (tokens.nextInt(number)) {
+                    system.kthSuspicious(number);
+                } else {
+                    out << "Incorrect" << '\n';
+                }
+                break;
+            case Command::SCOUNT:
+                system.suspiciousCount();
+                break;
+            case Command::UNDO:
+                system.undo();
+                break;
+            case Command::REDO:
+                system.redo();
+                break;
+            case Command::STATS: {
+                // STATS [ON|OFF|RESET]
+                string_view argument = tokens.next();
+                if (!tokens.empty() || !statsCommand(argument, out)) {
+                    out << "Incorrect" << '\n';
+                }
+                break;
+            }
+            case Command::UNKNOWN:
+                out << "Incorrect" << '\n';
+                break;
         }
     }
     return 0;
-}
\ No newline at end of file
+}
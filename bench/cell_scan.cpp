@@ -0,0 +1,85 @@
+// Ядра сканирования ячеек (cell_scan.h): сверка SSE2/AVX2 со скалярным эталоном
+// на случайных диапазонах и время прохода по зоне для каждого варианта.
+// Сборка из корня репозитория (или make bench-tools):
+//     g++ -std=c++17 -O2 -I. bench/cell_scan.cpp -o cell_scan
+// Запуск: ./cell_scan [ячеек в зоне] [повторов]
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "cell_scan.h"
+#include "output.h"
+using namespace std;
+
+using Clock = chrono::steady_clock;
+
+vector<ScanKernel> availableKernels() {
+    vector<ScanKernel> kernels = {ScanKernel::SCALAR};
+#ifdef CELL_SCAN_X86
+    if (__builtin_cpu_supports("sse2")) kernels.push_back(ScanKernel::SSE2);
+    if (__builtin_cpu_supports("avx2")) kernels.push_back(ScanKernel::AVX2);
+#endif
+    return kernels;
+}
+
+// Каждое ядро на каждом диапазоне должно совпасть со скалярным эталоном
+bool verify(const vector<int>& cells, const vector<ScanKernel>& kernels) {
+    mt19937 rng(3);
+    vector<uint64_t> expected, actual;
+    for (int trial = 0; trial < 20000; ++trial) {
+        size_t first = rng() % cells.size();
+        size_t count = rng() % (cells.size() - first + 1);
+        // Короткие диапазоны проверяют хвосты и границы слов
+        if (trial % 2 == 0) count = min<size_t>(count, rng() % 200);
+        bool empty = trial % 3 != 0;
+        CellTotals reference = sumCellsScalar(cells.data() + first, count);
+        expected.assign((count + 63) / 64, 0);
+        size_t marked = markCellsScalar(cells.data() + first, count, empty, expected.data());
+        for (ScanKernel kernel : kernels) {
+            CellTotals totals = sumCells(cells.data() + first, count, kernel);
+            actual.assign((count + 63) / 64, ~uint64_t(0));
+            size_t got = markCells(cells.data() + first, count, empty, actual.data(), kernel);
+            if (totals.units != reference.units || totals.occupied != reference.occupied || got != marked
+                || actual != expected) {
+                out << scanKernelName(kernel) << ": mismatch at [" << first << ", " << first + count << ")" << '\n';
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    size_t zone = argc > 1 ? static_cast<size_t>(atol(argv[1])) : 99 * 9 * 9;
+    int repeat = argc > 2 ? atoi(argv[2]) : 20000;
+    if (zone < 1) zone = 1;
+    if (repeat < 1) repeat = 1;
+    out.setInteractive(false);
+
+    // Половина ячеек пуста, остальные заполнены на 1..10 единиц
+    mt19937 rng(1);
+    vector<int> cells(zone * 4);
+    for (int& cell : cells) cell = rng() % 2 ? 1 + static_cast<int>(rng() % 10) : 0;
+
+    vector<ScanKernel> kernels = availableKernels();
+    if (!verify(cells, kernels)) return 1;
+    out << "verified against scalar reference on 20000 ranges" << '\n';
+
+    vector<uint64_t> bits((zone + 63) / 64);
+    for (ScanKernel kernel : kernels) {
+        long long checksum = 0;
+        Clock::time_point started = Clock::now();
+        for (int r = 0; r < repeat; ++r) {
+            checksum += sumCells(cells.data() + (r & 3) * zone, zone, kernel).units;
+        }
+        double count = chrono::duration<double, micro>(Clock::now() - started).count() / repeat;
+        started = Clock::now();
+        for (int r = 0; r < repeat; ++r) {
+            checksum += static_cast<long long>(markCells(cells.data() + (r & 3) * zone, zone, true, bits.data(), kernel));
+        }
+        double mark = chrono::duration<double, micro>(Clock::now() - started).count() / repeat;
+        out << scanKernelName(kernel) << ": zone of " << zone << " cells, COUNT " << Fixed{count, 2} << " us, EMPTY scan "
+            << Fixed{mark, 2} << " us (checksum " << checksum << ")" << '\n';
+    }
+    return 0;
+}
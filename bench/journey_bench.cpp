@@ -0,0 +1,123 @@
+// Нагрузочный тест поиска поездок (ROUTE) и поиска по расписанию (ARRIVE)
+// на синтетической сети размером с город.
+// Сборка из корня репозитория:
+//     g++ -std=c++17 -O2 -I. bench/journey_bench.cpp trolley.cpp -o journey_bench
+// Запуск: ./journey_bench [остановок] [маршрутов] [длина маршрута] [запросов]
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include "trolley.h"
+#include "output.h"
+using namespace std;
+
+int main(int argc, char* argv[]) {
+    int stops = argc > 1 ? atoi(argv[1]) : 5000;
+    int routes = argc > 2 ? atoi(argv[2]) : 400;
+    int length = argc > 3 ? atoi(argv[3]) : 40;
+    int queries = argc > 4 ? atoi(argv[4]) : 20000;
+    out.setInteractive(false);
+
+    // Остановки стоят на квадратной сетке, маршрут - случайное блуждание по соседям
+    int side = 1;
+    while (side * side < stops) ++side;
+    mt19937 rng(12345);
+    vector<string> names(stops);
+    for (int i = 0; i < stops; ++i) {
+        names[i] = "S" + to_string(i);
+    }
+
+    TrolleySystem system;
+    vector<string_view> route;
+    string trolley;
+    auto started = chrono::steady_clock::now();
+    for (int r = 0; r < routes; ++r) {
+        route.clear();
+        int stop = static_cast<int>(rng() % stops);
+        for (int k = 0; k < length; ++k) {
+            route.push_back(names[stop]);
+            int x = stop % side;
+            int y = stop / side;
+            switch (rng() % 4) {
+                case 0: x = min(x + 1, side - 1); break;
+                case 1: x = max(x - 1, 0); break;
+                case 2: y = min(y + 1, side - 1); break;
+                case 3: y = max(y - 1, 0); break;
+            }
+            stop = min(y * side + x, stops - 1);
+        }
+        trolley = "R" + to_string(r);
+        system.createTrolley(trolley, route);
+        // Полный день: рейсы каждые 10 минут с 05:00 до 24:00, перегон 2 минуты
+        system.setSegmentTimes(trolley, vector<int>(length - 1, 2));
+        system.addDepartures(trolley, 5 * 60, 24 * 60, 10);
+    }
+    auto built = chrono::steady_clock::now();
+
+    // Запросы идут от небольшого набора популярных остановок, как у реальных пассажиров
+    vector<int> sources(16);
+    for (int& source : sources) {
+        source = static_cast<int>(rng() % stops);
+    }
+
+    Journey journey;
+    long long found = 0;
+    long long transfers = 0;
+    auto cold = chrono::steady_clock::duration::zero();
+    auto warm = chrono::steady_clock::duration::zero();
+    int cold_count = 0;
+    vector<char> seen(stops, 0);
+    for (int q = 0; q < queries; ++q) {
+        int from = sources[rng() % sources.size()];
+        int to = static_cast<int>(rng() % stops);
+        auto t0 = chrono::steady_clock::now();
+        system.findJourney(names[from], names[to], journey);
+        auto t1 = chrono::steady_clock::now();
+        if (!seen[from]) {
+            seen[from] = 1;
+            cold += t1 - t0;
+            ++cold_count;
+        } else {
+            warm += t1 - t0;
+        }
+        if (journey.found) {
+            ++found;
+            transfers += journey.transfers;
+        }
+    }
+
+    auto us = [](chrono::steady_clock::duration d) {
+        return chrono::duration_cast<chrono::microseconds>(d).count();
+    };
+    int warm_count = queries - cold_count;
+    out << "network: " << stops << " stops, " << routes << " routes x " << length << " stops, built in "
+        << us(built - started) << " us" << '\n';
+    out << "queries: " << queries << ", found " << found << ", average transfers "
+        << Fixed{found ? static_cast<double>(transfers) / found : 0.0, 2} << '\n';
+    out << "cold (new source): " << cold_count << " queries, "
+        << Fixed{cold_count ? static_cast<double>(us(cold)) / cold_count : 0.0, 1} << " us/query" << '\n';
+    out << "cached source: " << warm_count << " queries, "
+        << Fixed{warm_count ? static_cast<double>(us(warm)) / warm_count : 0.0, 2} << " us/query" << '\n';
+
+    Arrival arrival;
+    long long arrived = 0;
+    long long minutes = 0;
+    auto timed = chrono::steady_clock::duration::zero();
+    for (int q = 0; q < queries; ++q) {
+        int from = static_cast<int>(rng() % stops);
+        int to = static_cast<int>(rng() % stops);
+        int time = 6 * 60 + static_cast<int>(rng() % (16 * 60));
+        auto t0 = chrono::steady_clock::now();
+        system.findArrival(names[from], names[to], time, arrival);
+        timed += chrono::steady_clock::now() - t0;
+        if (arrival.found) {
+            ++arrived;
+            minutes += arrival.arrival - time;
+        }
+    }
+    out << "timetable: " << queries << " queries, found " << arrived << ", average trip "
+        << Fixed{arrived ? static_cast<double>(minutes) / arrived : 0.0, 1} << " min, "
+        << Fixed{static_cast<double>(us(timed)) / queries, 1} << " us/query" << '\n';
+    return 0;
+}
@@ -0,0 +1,91 @@
+// Масштабирование моделирования очереди (queue_simulation.h) по числу потоков
+// пула с перехватом задач. Перед замером simulate_day сверяется с distribute_queue
+// из Task2 (visitor_queue.h), а результат каждого прогона - с однопоточным.
+// Сборка из корня репозитория (или make bench-tools):
+//     g++ -std=c++17 -O2 -I. bench/queue_simulation.cpp -o queue_simulation -pthread
+// Запуск: ./queue_simulation [максимум потоков] [дней] [посетителей в день]
+#include <chrono>
+#include <cstdlib>
+#include <queue>
+#include <thread>
+#include <vector>
+#include "output.h"
+#include "queue_simulation.h"
+#include "visitor_queue.h"
+using namespace std;
+
+bool sameResults(const vector<WindowsResult>& a, const vector<WindowsResult>& b) {
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].makespans != b[i].makespans || a[i].busy != b[i].busy || a[i].open != b[i].open
+            || !(a[i].waits == b[i].waits)) {
+            return false;
+        }
+    }
+    return a.size() == b.size();
+}
+
+// simulate_day должен распределять посетителей так же, как distribute_queue:
+// совпадают максимальная загрузка и ожидание каждого посетителя
+bool matchesDistributeQueue() {
+    SimulationConfig config;
+    vector<int> durations;
+    vector<pair<long long, int>> heap;
+    for (Distribution distribution : {Distribution::EXPONENTIAL, Distribution::UNIFORM}) {
+        config.distribution = distribution;
+        for (int day = 0; day < 2000; ++day) {
+            config.visitors = 1 + day % 97;
+            generate_day(config, day, durations);
+            for (int windows = 1; windows <= 9; ++windows) {
+                queue<Visitor> visitors;
+                for (int duration : durations) visitors.push({"", duration});
+                vector<Window> reference = distribute_queue(visitors, windows);
+                WaitCounts expected;
+                for (const Window& window : reference) {
+                    long long start = 0;
+                    for (const Visitor& visitor : window.visitors) {
+                        expected.add(start);
+                        start += visitor.duration;
+                    }
+                }
+
+                WaitCounts waits;
+                long long result = simulate_day(durations, windows, heap, waits);
+                if (result != makespan(reference) || !(waits == expected)) {
+                    out << "simulate_day differs from distribute_queue: day " << day << ", " << windows << " windows" << '\n';
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    int max_threads = argc > 1 ? atoi(argv[1]) : static_cast<int>(thread::hardware_concurrency());
+    if (max_threads < 1) max_threads = 1;
+    SimulationConfig config;
+    config.days = argc > 2 ? atoi(argv[2]) : 20000;
+    config.visitors = argc > 3 ? atoi(argv[3]) : 200;
+    out.setInteractive(false);
+
+    if (!matchesDistributeQueue()) return 1;
+    out << "simulate_day matches distribute_queue on 2 x 2000 days x 1..9 windows" << '\n';
+
+    vector<WindowsResult> reference;
+    double single = 0;
+    for (int threads = 1; threads <= max_threads; ++threads) {
+        config.threads = static_cast<size_t>(threads);
+        auto started = chrono::steady_clock::now();
+        vector<WindowsResult> results = simulate_queue(config);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        if (threads == 1) reference = results;
+        if (!sameResults(reference, results)) {
+            out << threads << " threads: results differ from the single-threaded run" << '\n';
+            return 1;
+        }
+        double rate = static_cast<double>(config.days) * static_cast<double>(results.size()) / seconds;
+        if (threads == 1) single = rate;
+        out << threads << " threads: " << Fixed{rate / 1000, 1} << " k days/s, speedup " << Fixed{rate / single, 2} << '\n';
+    }
+    return 0;
+}
@@ -0,0 +1,206 @@
+// Замер одной программы на файле нагрузки: пропускная способность, задержка
+// команд (p50/p99) и пиковая память (ru_maxrss из wait4).
+// Сборка из корня репозитория (или make bench-tools):
+//     g++ -std=c++17 -O2 -I. bench/runner.cpp -o runner
+// Запуск:
+//     ./runner [--label L] [--repeat R] [--prompt P [--prompt-arg A]...] <нагрузка> -- <программа> [аргументы]
+//
+// Пакетный прогон подаёт файл нагрузки на stdin целиком, вывод уходит в /dev/null;
+// время и команды в секунду берутся из лучшего из R прогонов. Если задано
+// приглашение P (">>> " у склада, "<<< " у очереди, у Task3/Task4 - то, что задано
+// их ключом --prompt), следующий прогон идёт шаг за шагом: команда отправляется,
+// когда программа напечатала приглашение, и задержка команды - время до следующего
+// приглашения. Аргументы A (например --interactive) добавляются программе только
+// в этом прогоне, чтобы она печатала приглашение и сбрасывала вывод перед вводом
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "output.h"
+using namespace std;
+
+using Clock = chrono::steady_clock;
+
+// Сколько ждать ответа программы, прежде чем признать её зависшей
+constexpr int RESPONSE_TIMEOUT_MS = 10000;
+
+struct Result {
+    bool ok = false;
+    double seconds = 0;
+    long peak_rss_kib = 0;
+};
+
+// Запуск программы с заданными stdin/stdout; остальные дескрипторы из extra закрываются в потомке
+pid_t spawn(const vector<string>& command, int input, int output, const vector<int>& extra) {
+    pid_t pid = fork();
+    if (pid != 0) return pid;
+    dup2(input, STDIN_FILENO);
+    dup2(output, STDOUT_FILENO);
+    for (int fd : extra) close(fd);
+    vector<char*> args;
+    for (const string& arg : command) args.push_back(const_cast<char*>(arg.c_str()));
+    args.push_back(nullptr);
+    execvp(args[0], args.data());
+    _exit(127);
+}
+
+// Ожидание завершения; пиковая память берётся из rusage завершившегося процесса
+bool finish(pid_t pid, Result& result) {
+    int status = 0;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) != pid) return false;
+    result.peak_rss_kib = usage.ru_maxrss;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+Result runBatch(const string& workload, const vector<string>& command) {
+    Result result;
+    int input = open(workload.c_str(), O_RDONLY);
+    int output = open("/dev/null", O_WRONLY);
+    if (input < 0 || output < 0) return result;
+    Clock::time_point started = Clock::now();
+    pid_t pid = spawn(command, input, output, {input, output});
+    close(input);
+    close(output);
+    if (pid < 0) return result;
+    result.ok = finish(pid, result);
+    result.seconds = chrono::duration<double>(Clock::now() - started).count();
+    return result;
+}
+
+// Чтение вывода до приглашения или конца вывода; false, если программа не ответила
+bool awaitPrompt(int fd, string_view prompt, string& tail) {
+    char buffer[1 << 16];
+    while (tail.size() < prompt.size() || string_view(tail).substr(tail.size() - prompt.size()) != prompt) {
+        struct pollfd ready = {fd, POLLIN, 0};
+        if (poll(&ready, 1, RESPONSE_TIMEOUT_MS) <= 0) return false;
+        ssize_t got = read(fd, buffer, sizeof(buffer));
+        if (got <= 0) return true;
+        // Для сравнения с приглашением достаточно хвоста вывода
+        tail.append(buffer, static_cast<size_t>(got));
+        if (tail.size() > prompt.size()) tail.erase(0, tail.size() - prompt.size());
+    }
+    tail.clear();
+    return true;
+}
+
+Result runLockstep(const vector<string>& lines, const vector<string>& command, string_view prompt,
+                   vector<double>& latencies) {
+    Result result;
+    int to_child[2], from_child[2];
+    if (pipe(to_child) != 0) return result;
+    if (pipe(from_child) != 0) {
+        close(to_child[0]);
+        close(to_child[1]);
+        return result;
+    }
+    pid_t pid = spawn(command, to_child[0], from_child[1], {to_child[0], to_child[1], from_child[0], from_child[1]});
+    close(to_child[0]);
+    close(from_child[1]);
+    if (pid < 0) {
+        close(to_child[1]);
+        close(from_child[0]);
+        return result;
+    }
+
+    string tail;
+    bool responsive = awaitPrompt(from_child[0], prompt, tail);
+    Clock::time_point started = Clock::now();
+    for (size_t i = 0; responsive && i < lines.size(); ++i) {
+        Clock::time_point sent = Clock::now();
+        // Программа может завершиться раньше конца нагрузки (EXIT, DISTRIBUTE в Rust-версии)
+        if (!writeAll(to_child[1], lines[i].data(), lines[i].size())) break;
+        responsive = awaitPrompt(from_child[0], prompt, tail);
+        latencies.push_back(chrono::duration<double, micro>(Clock::now() - sent).count());
+    }
+    result.seconds = chrono::duration<double>(Clock::now() - started).count();
+    close(to_child[1]);
+    if (!responsive) kill(pid, SIGKILL);
+    // Остаток вывода дочитывается, чтобы программа не встала на заполненном канале
+    char buffer[1 << 16];
+    while (read(from_child[0], buffer, sizeof(buffer)) > 0) {}
+    close(from_child[0]);
+    result.ok = finish(pid, result) && responsive;
+    return result;
+}
+
+double percentile(vector<double>& values, double fraction) {
+    if (values.empty()) return 0;
+    size_t index = min(values.size() - 1, static_cast<size_t>(fraction * static_cast<double>(values.size())));
+    nth_element(values.begin(), values.begin() + static_cast<long>(index), values.end());
+    return values[index];
+}
+
+int main(int argc, char* argv[]) {
+    string label;
+    string prompt;
+    vector<string> prompt_args;
+    string workload;
+    int repeat = 3;
+    int i = 1;
+    for (; i < argc; ++i) {
+        string_view arg = argv[i];
+        if (arg == "--") {
+            ++i;
+            break;
+        }
+        if (arg == "--label" && i + 1 < argc) label = argv[++i];
+        else if (arg == "--repeat" && i + 1 < argc) repeat = max(1, atoi(argv[++i]));
+        else if (arg == "--prompt" && i + 1 < argc) prompt = argv[++i];
+        else if (arg == "--prompt-arg" && i + 1 < argc) prompt_args.push_back(argv[++i]);
+        else workload = argv[i];
+    }
+    vector<string> command(argv + i, argv + argc);
+    if (workload.empty() || command.empty()) {
+        out << "Usage: runner [--label L] [--repeat R] [--prompt P [--prompt-arg A]...] <workload> -- <program> [args]" << '\n';
+        return 1;
+    }
+    if (label.empty()) label = command[0];
+    signal(SIGPIPE, SIG_IGN);
+
+    vector<string> lines;
+    ifstream input(workload);
+    for (string line; getline(input, line);) {
+        if (!line.empty()) lines.push_back(line + '\n');
+    }
+    if (lines.empty()) {
+        out << label << ": cannot read workload " << workload << '\n';
+        return 1;
+    }
+
+    Result best;
+    for (int run = 0; run < repeat; ++run) {
+        Result result = runBatch(workload, command);
+        if (!result.ok) {
+            out << label << ": program failed" << '\n';
+            return 1;
+        }
+        if (run == 0 || result.seconds < best.seconds) best.seconds = result.seconds;
+        best.peak_rss_kib = max(best.peak_rss_kib, result.peak_rss_kib);
+    }
+
+    out << label << ": " << lines.size() << " commands, " << Fixed{best.seconds * 1000, 1} << " ms, "
+        << Fixed{static_cast<double>(lines.size()) / best.seconds / 1000, 1} << " k cmd/s";
+    if (!prompt.empty()) {
+        vector<string> lockstep = command;
+        lockstep.insert(lockstep.end(), prompt_args.begin(), prompt_args.end());
+        vector<double> latencies;
+        Result result = runLockstep(lines, lockstep, prompt, latencies);
+        if (!result.ok) {
+            out << ", lockstep run failed" << '\n';
+            return 1;
+        }
+        out << ", p50 " << Fixed{percentile(latencies, 0.5), 1} << " us, p99 " << Fixed{percentile(latencies, 0.99), 1} << " us";
+    }
+    out << ", peak RSS " << best.peak_rss_kib << " KiB" << '\n';
+    return 0;
+}
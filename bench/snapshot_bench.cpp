@@ -0,0 +1,98 @@
+// Загрузка сети из снимка (LOAD) против построения командами CREATE_TRL.
+// Перед замером проверяется, что снимок с расписанием на границе
+// MAX_SCHEDULE_MINUTES, которое приняли SCHEDULE и DEPART, загружается обратно.
+// Сборка из корня репозитория:
+//     g++ -std=c++17 -O2 -I. bench/snapshot_bench.cpp trolley.cpp -o snapshot_bench
+// Запуск: ./snapshot_bench [маршрутов] [длина маршрута] [файл снимка]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include "trolley.h"
+#include "output.h"
+using namespace std;
+
+// SAVE -> LOAD на наибольшем допустимом времени в пути; на единицу больше SCHEDULE не примет
+bool scheduleLimitRoundTrip(const string& path) {
+    TrolleySystem system;
+    system.createTrolley("T", {"A", "B", "C"});
+    if (system.setSegmentTimes("T", {1, MAX_SCHEDULE_MINUTES})) return false;
+    if (!system.setSegmentTimes("T", {1, MAX_SCHEDULE_MINUTES - 2})) return false;
+    if (!system.addDepartures("T", {47 * 60 + 59})) return false;
+    if (!system.save(path)) return false;
+
+    TrolleySystem loaded;
+    bool ok = loaded.load(path);
+    Arrival before, after;
+    ok = ok && system.findArrival("A", "C", 0, before) && loaded.findArrival("A", "C", 0, after)
+         && before.arrival == after.arrival && after.arrival == 47 * 60 + 59 + MAX_SCHEDULE_MINUTES - 1;
+    remove(path.c_str());
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    int routes = argc > 1 ? atoi(argv[1]) : 100000;
+    int length = argc > 2 ? atoi(argv[2]) : 30;
+    string path = argc > 3 ? argv[3] : "snapshot_bench.snap";
+    out.setInteractive(false);
+    if (!scheduleLimitRoundTrip(path)) {
+        out << "snapshot with the longest accepted schedule does not load back" << '\n';
+        return 1;
+    }
+
+    // Маршруты проходят по случайным остановкам из общего пула
+    int stops = routes * 4;
+    mt19937 rng(12345);
+    vector<string> names(stops);
+    for (int i = 0; i < stops; ++i) {
+        names[i] = "Stop" + to_string(i);
+    }
+
+    auto ms = [](chrono::steady_clock::duration d) {
+        return Fixed{chrono::duration<double, milli>(d).count(), 1};
+    };
+
+    TrolleySystem built;
+    vector<string_view> route;
+    string trolley;
+    auto t0 = chrono::steady_clock::now();
+    for (int r = 0; r < routes; ++r) {
+        route.clear();
+        for (int k = 0; k < length; ++k) {
+            route.push_back(names[rng() % stops]);
+        }
+        trolley = "R" + to_string(r);
+        built.createTrolley(trolley, route);
+    }
+    auto t1 = chrono::steady_clock::now();
+    if (!built.save(path)) {
+        out << "cannot save " << path << '\n';
+        return 1;
+    }
+    auto t2 = chrono::steady_clock::now();
+
+    TrolleySystem loaded;
+    if (!loaded.load(path)) {
+        out << "cannot load " << path << '\n';
+        return 1;
+    }
+    auto t3 = chrono::steady_clock::now();
+
+    // Запросы после загрузки читают таблицу имён прямо из отображённого файла
+    int found = 0;
+    for (int i = 0; i < 100000; ++i) {
+        found += loaded.isStopExist(names[rng() % stops]);
+    }
+    auto t4 = chrono::steady_clock::now();
+
+    out << "network: " << built.trolleyCount() << " routes x " << length << " stops, "
+        << built.stopCount() << " distinct stops" << '\n';
+    out << "build with CREATE_TRL: " << ms(t1 - t0) << " ms" << '\n';
+    out << "save: " << ms(t2 - t1) << " ms" << '\n';
+    out << "load: " << ms(t3 - t2) << " ms, " << loaded.trolleyCount() << " routes" << '\n';
+    out << "100000 stop lookups after load: " << ms(t4 - t3) << " ms, found " << found << '\n';
+    remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,105 @@
+// Склад с геометрией, заданной при запуске (Warehouse), против геометрии,
+// известной при компиляции (FixedWarehouse), на раскладке 1x10x7x4 по 10 единиц.
+// Замеряются разбор адреса, ADD/REMOVE по адресу без вывода и INFO в /dev/null.
+// Сборка из корня репозитория (или make bench-tools):
+//     g++ -std=c++17 -O2 -I. bench/warehouse_geometry.cpp -o warehouse_geometry -pthread
+// Запуск: ./warehouse_geometry [повторов]
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "warehouse.h"
+using namespace std;
+
+using Clock = chrono::steady_clock;
+
+double nanosSince(Clock::time_point started, long long operations) {
+    return chrono::duration<double, nano>(Clock::now() - started).count() / static_cast<double>(operations);
+}
+
+// Случайные адреса: большинство верные, часть - с неверной зоной, номером или символом
+vector<string> makeAddresses(size_t count) {
+    mt19937 rng(7);
+    vector<string> addresses(count);
+    for (string& address : addresses) {
+        int shelf = 1 + static_cast<int>(rng() % 10);
+        address = "A";
+        address += static_cast<char>('0' + shelf / 10);
+        address += static_cast<char>('0' + shelf % 10);
+        address += static_cast<char>('1' + rng() % 7);
+        address += static_cast<char>('1' + rng() % 4);
+        switch (rng() % 10) {
+            case 0: address[0] = 'B'; break;
+            case 1: address[3] = '9'; break;
+            case 2: address[2] = ':'; break;
+            default: break;
+        }
+    }
+    return addresses;
+}
+
+template <typename Store>
+void run(const char* name, Store& warehouse, const vector<string>& addresses, int repeat, Output& sink) {
+    // Разбор адреса
+    long long checksum = 0;
+    Clock::time_point started = Clock::now();
+    for (int r = 0; r < repeat; ++r) {
+        for (const string& address : addresses) {
+            checksum += warehouse.Slot(address);
+        }
+    }
+    double decode = nanosSince(started, static_cast<long long>(repeat) * static_cast<long long>(addresses.size()));
+
+    // ADD и REMOVE по одному адресу: склад после каждой пары возвращается в исходное состояние
+    string product = "P";
+    long long pairs = 0;
+    started = Clock::now();
+    for (int r = 0; r < repeat; ++r) {
+        for (const string& address : addresses) {
+            if (warehouse.TryAdd(product, 1, address)) {
+                warehouse.TryRemove(product, 1, address);
+                ++pairs;
+            }
+        }
+    }
+    double update = nanosSince(started, pairs * 2);
+
+    int reports = repeat * 100;
+    started = Clock::now();
+    for (int r = 0; r < reports; ++r) {
+        warehouse.INFO(sink);
+    }
+    sink.flush();
+    double info = nanosSince(started, reports);
+
+    out << name << ": Slot " << Fixed{decode, 2} << " ns, ADD/REMOVE " << Fixed{update, 1} << " ns, INFO "
+        << Fixed{info, 1} << " ns (checksum " << checksum << ")" << '\n';
+}
+
+int main(int argc, char* argv[]) {
+    int repeat = argc > 1 ? atoi(argv[1]) : 200;
+    if (repeat < 1) repeat = 1;
+    out.setInteractive(false);
+
+    vector<string> addresses = makeAddresses(4096);
+    int null_fd = open("/dev/null", O_WRONLY);
+    Output sink(null_fd);
+
+    // Обе геометрии обязаны одинаково разбирать любой адрес
+    Warehouse runtime(1, 10, 7, 4, 2800);
+    FixedWarehouse<1, 10, 7, 4, 10> fixed;
+    for (const string& address : addresses) {
+        if (runtime.Slot(address) != fixed.Slot(address)) {
+            out << "Slot mismatch for " << address << '\n';
+            return 1;
+        }
+    }
+
+    run("runtime geometry", runtime, addresses, repeat, sink);
+    run("fixed geometry  ", fixed, addresses, repeat, sink);
+    close(null_fd);
+    return 0;
+}
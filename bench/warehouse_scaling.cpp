@@ -0,0 +1,89 @@
+// Масштабирование склада с шардами по зонам (ShardedWarehouse) по числу потоков.
+// Ячейки всех зон перемешиваются и делятся между потоками поровну, так что
+// каждый поток выполняет ADD и REMOVE только в своих ячейках и операции не
+// мешают друг другу; в скорость идут только успешные операции. Ответы
+// пишутся в /dev/null. Сборка из корня репозитория:
+//     g++ -std=c++17 -O2 -I. bench/warehouse_scaling.cpp -o warehouse_scaling -pthread
+// Запуск: ./warehouse_scaling [максимум потоков] [зон] [операций на поток]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "warehouse.h"
+using namespace std;
+
+int main(int argc, char* argv[]) {
+    int max_threads = argc > 1 ? atoi(argv[1]) : static_cast<int>(thread::hardware_concurrency());
+    int zones = argc > 2 ? atoi(argv[2]) : 8;
+    int operations = argc > 3 ? atoi(argv[3]) : 200000;
+    zones = max(1, min(zones, 26));
+    // У каждого потока должна быть хотя бы одна своя ячейка
+    max_threads = max(1, min(max_threads, zones * 10 * 7 * 4));
+    out.setInteractive(false);
+
+    int null_fd = open("/dev/null", O_WRONLY);
+    double single = 0;
+    for (int threads = 1; threads <= max_threads; ++threads) {
+        ShardedWarehouse warehouse(zones, 10, 7, 4, 2800);
+
+        // Адреса готовятся заранее, чтобы в замер попали только операции склада
+        vector<string> cells;
+        for (int zone = 0; zone < zones; ++zone) {
+            for (int shelf = 1; shelf <= 10; ++shelf) {
+                for (int section = 1; section <= 7; ++section) {
+                    for (int level = 1; level <= 4; ++level) {
+                        string address(1, static_cast<char>('A' + zone));
+                        address += static_cast<char>('0' + shelf / 10);
+                        address += static_cast<char>('0' + shelf % 10);
+                        address += static_cast<char>('0' + section);
+                        address += static_cast<char>('0' + level);
+                        cells.push_back(address);
+                    }
+                }
+            }
+        }
+        shuffle(cells.begin(), cells.end(), mt19937(1000));
+        vector<vector<string>> addresses(threads);
+        for (size_t i = 0; i < cells.size(); ++i) {
+            addresses[i % threads].push_back(cells[i]);
+        }
+
+        atomic<long long> succeeded{0};
+        auto started = chrono::steady_clock::now();
+        vector<thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                auto sink = make_unique<Output>(null_fd);
+                string product = "P" + to_string(t);
+                const vector<string>& mine = addresses[t];
+                long long done = 0;
+                for (int i = 0; i < operations; i += 2) {
+                    const string& address = mine[(i / 2) % mine.size()];
+                    done += warehouse.ADD(product, 1, address, *sink);
+                    done += warehouse.REMOVE(product, 1, address, *sink);
+                }
+                succeeded += done;
+            });
+        }
+        for (thread& worker : workers) {
+            worker.join();
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        double rate = static_cast<double>(succeeded) / seconds;
+        if (threads == 1) single = rate;
+        out << threads << " threads, " << zones << " zones: " << Fixed{rate / 1e6, 2} << " M ops/s, speedup "
+            << Fixed{rate / single, 2};
+        long long failed = static_cast<long long>((operations + 1) / 2 * 2) * threads - succeeded;
+        if (failed > 0) out << ", failed " << failed;
+        out << '\n';
+    }
+    close(null_fd);
+    return 0;
+}
@@ -0,0 +1,183 @@
+// Детерминированный генератор нагрузки для программ Task1-Task4 и их Rust-версий.
+// Один и тот же вид нагрузки с тем же зерном всегда даёт один и тот же поток команд.
+// Сборка из корня репозитория (или make bench-tools):
+//     g++ -std=c++17 -O2 -I. bench/workload.cpp -o workload
+// Запуск:
+//     ./workload warehouse [--count N] [--seed S] [--info P]   ADD/REMOVE/INFO, P - процент INFO
+//     ./workload queue [--count N] [--seed S] [--windows W]    окна, N посетителей, DISTRIBUTE
+//     ./workload trolley [--count N] [--seed S] [--stops K]    сеть троллейбусов и запросы к ней
+//     ./workload students [--count N] [--seed S]               команды системы студентов
+#include <algorithm>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "output.h"
+using namespace std;
+
+struct Options {
+    int count = 10000;
+    unsigned seed = 1;
+    int info = 1;
+    int windows = 5;
+    int stops = 200;
+};
+
+// Равномерное целое из [low, high]
+int uniform(mt19937& rng, int low, int high) {
+    return low + static_cast<int>(rng() % static_cast<unsigned>(high - low + 1));
+}
+
+// Склад одной зоны 10x7x4 по 10 единиц в ячейке. Генератор ведёт свою модель
+// склада, поэтому почти все операции корректны и меняют состояние, как у
+// пользователя, а не упираются в ошибки
+void warehouse(const Options& options, mt19937& rng) {
+    const int cells = 10 * 7 * 4;
+    const int capacity = 10;
+    vector<int> product(cells, -1);
+    vector<int> quantity(cells, 0);
+    vector<int> occupied;
+    int full = 0;
+
+    auto address = [](int cell) {
+        int shelf = cell / 28 + 1;
+        int section = cell / 4 % 7 + 1;
+        int level = cell % 4 + 1;
+        out << 'A' << static_cast<char>('0' + shelf / 10) << static_cast<char>('0' + shelf % 10)
+            << static_cast<char>('0' + section) << static_cast<char>('0' + level);
+    };
+
+    for (int i = 0; i < options.count; ++i) {
+        int roll = uniform(rng, 1, 100);
+        if (roll <= options.info) {
+            out << "INFO" << '\n';
+            continue;
+        }
+        bool add = occupied.empty() || (roll <= options.info + (100 - options.info) * 55 / 100 && full < cells);
+        if (add) {
+            int cell = uniform(rng, 0, cells - 1);
+            while (quantity[cell] == capacity) cell = uniform(rng, 0, cells - 1);
+            if (product[cell] < 0) {
+                product[cell] = uniform(rng, 1, 50);
+                occupied.push_back(cell);
+            }
+            int amount = uniform(rng, 1, capacity - quantity[cell]);
+            quantity[cell] += amount;
+            if (quantity[cell] == capacity) ++full;
+            out << "ADD P" << product[cell] << ' ' << amount << ' ';
+            address(cell);
+            out << '\n';
+        } else {
+            size_t index = static_cast<size_t>(uniform(rng, 0, static_cast<int>(occupied.size()) - 1));
+            int cell = occupied[index];
+            int amount = uniform(rng, 1, quantity[cell]);
+            out << "REMOVE P" << product[cell] << ' ' << amount << ' ';
+            address(cell);
+            out << '\n';
+            if (quantity[cell] == capacity) --full;
+            quantity[cell] -= amount;
+            if (quantity[cell] == 0) {
+                product[cell] = -1;
+                occupied[index] = occupied.back();
+                occupied.pop_back();
+            }
+        }
+    }
+    out << "EXIT" << '\n';
+}
+
+// Электронная очередь: число окон, поток посетителей и распределение
+void queue(const Options& options, mt19937& rng) {
+    out << options.windows << '\n';
+    for (int i = 0; i < options.count; ++i) {
+        out << "ENQUEUE " << uniform(rng, 1, 60) << '\n';
+    }
+    out << "DISTRIBUTE" << '\n';
+    out << "EXIT" << '\n';
+}
+
+// Сеть троллейбусов: четверть команд создаёт маршруты, остальные - запросы
+void trolley(const Options& options, mt19937& rng) {
+    int trolleys = max(1, options.count / 4);
+    vector<int> stops(static_cast<size_t>(options.stops));
+    iota(stops.begin(), stops.end(), 0);
+    for (int t = 0; t < trolleys; ++t) {
+        int length = uniform(rng, 2, min(20, options.stops));
+        // Первые length остановок случайной перестановки - маршрут без повторов
+        for (int i = 0; i < length; ++i) {
+            swap(stops[static_cast<size_t>(i)], stops[static_cast<size_t>(uniform(rng, i, options.stops - 1))]);
+        }
+        out << "CREATE_TRL T" << t;
+        for (int i = 0; i < length; ++i) {
+            out << " S" << stops[static_cast<size_t>(i)];
+        }
+        out << '\n';
+    }
+    for (int i = trolleys; i < options.count; ++i) {
+        int roll = uniform(rng, 1, 100);
+        if (roll <= 40) {
+            out << "TRL_IN_STOP S" << uniform(rng, 0, options.stops - 1) << '\n';
+        } else if (roll <= 75) {
+            out << "STOPS_IN_TRL T" << uniform(rng, 0, trolleys - 1) << '\n';
+        } else if (roll <= 99) {
+            out << "ROUTE S" << uniform(rng, 0, options.stops - 1) << " S" << uniform(rng, 0, options.stops - 1) << '\n';
+        } else {
+            out << "TRLS" << '\n';
+        }
+    }
+}
+
+// Система студентов: первая строка - число команд
+void students(const Options& options, mt19937& rng) {
+    out << options.count << '\n';
+    int total = 0;
+    for (int i = 0; i < options.count; ++i) {
+        int roll = uniform(rng, 1, 100);
+        if (total == 0 || roll <= 10) {
+            int number = uniform(rng, 1, 100);
+            total += number;
+            out << "NEW_STUDENTS " << number << '\n';
+        } else if (roll <= 50) {
+            out << "SUSPICIOUS " << uniform(rng, 1, total) << '\n';
+        } else if (roll <= 70) {
+            out << "IMMORTIAL " << uniform(rng, 1, total) << '\n';
+        } else if (roll <= 85) {
+            out << "SCOUNT" << '\n';
+        } else if (roll <= 95) {
+            out << "TOP-LIST " << uniform(rng, 0, total) << " 20" << '\n';
+        } else {
+            out << "KTH " << uniform(rng, 1, total) << '\n';
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        out << "Usage: workload warehouse|queue|trolley|students [--count N] [--seed S] [--info P] [--windows W] [--stops K]" << '\n';
+        return 1;
+    }
+    string_view kind = argv[1];
+    Options options;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        string_view key = argv[i];
+        int value = atoi(argv[i + 1]);
+        if (key == "--count") options.count = max(1, value);
+        else if (key == "--seed") options.seed = static_cast<unsigned>(value);
+        else if (key == "--info") options.info = clamp(value, 0, 100);
+        else if (key == "--windows") options.windows = max(1, value);
+        else if (key == "--stops") options.stops = max(2, value);
+    }
+
+    mt19937 rng(options.seed);
+    if (kind == "warehouse") warehouse(options, rng);
+    else if (kind == "queue") queue(options, rng);
+    else if (kind == "trolley") trolley(options, rng);
+    else if (kind == "students") students(options, rng);
+    else {
+        out << "Unknown workload " << kind << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,190 @@
+#ifndef CELL_SCAN_H
+#define CELL_SCAN_H
+
+#include <cstddef>
+#include <cstdint>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CELL_SCAN_X86 1
+#endif
+
+// Проход по подряд идущим количествам ячеек для команд над диапазонами склада
+// (COUNT, EMPTY, CLEAR). Два ядра:
+//   sumCells  - сумма единиц и число занятых ячеек;
+//   markCells - битовая карта пустых (или занятых) ячеек: бит i слова w отвечает
+//               ячейке 64 * w + i, вызывающий код обходит биты через ctz.
+// Каждое ядро есть в трёх вариантах: скалярный (он же эталон для проверки), SSE2
+// и AVX2. Векторные варианты собраны с атрибутом target, поэтому файл не требует
+// -mavx2, а вариант выбирается один раз по возможностям процессора.
+// Количества неотрицательны: на этом построено расширение сумм до 64 бит.
+struct CellTotals {
+    long long units = 0;
+    long long occupied = 0;
+};
+
+enum class ScanKernel {
+    SCALAR,
+    SSE2,
+    AVX2
+};
+
+inline const char* scanKernelName(ScanKernel kernel) {
+    switch (kernel) {
+        case ScanKernel::SCALAR: return "scalar";
+        case ScanKernel::SSE2: return "sse2";
+        case ScanKernel::AVX2: return "avx2";
+    }
+    return "";
+}
+
+inline CellTotals sumCellsScalar(const int* cells, size_t count) {
+    CellTotals totals;
+    for (size_t i = 0; i < count; ++i) {
+        totals.units += cells[i];
+        totals.occupied += cells[i] != 0;
+    }
+    return totals;
+}
+
+// Возвращает число отмеченных ячеек; bits должен вмещать (count + 63) / 64 слов
+inline size_t markCellsScalar(const int* cells, size_t count, bool empty, uint64_t* bits) {
+    size_t marked = 0;
+    for (size_t w = 0; w * 64 < count; ++w) {
+        uint64_t word = 0;
+        size_t end = count - w * 64 < 64 ? count - w * 64 : 64;
+        for (size_t i = 0; i < end; ++i) {
+            word |= static_cast<uint64_t>((cells[w * 64 + i] == 0) == empty) << i;
+        }
+        bits[w] = word;
+        marked += static_cast<size_t>(__builtin_popcountll(word));
+    }
+    return marked;
+}
+
+#ifdef CELL_SCAN_X86
+
+__attribute__((target("sse2")))
+inline CellTotals sumCellsSse2(const int* cells, size_t count) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i units = zero;  // два 64-битных счётчика
+    __m128i empty = zero;  // четыре 32-битных счётчика пустых ячеек
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cells + i));
+        units = _mm_add_epi64(units, _mm_unpacklo_epi32(v, zero));
+        units = _mm_add_epi64(units, _mm_unpackhi_epi32(v, zero));
+        // Сравнение даёт -1 в пустых ячейках
+        empty = _mm_sub_epi32(empty, _mm_cmpeq_epi32(v, zero));
+    }
+    alignas(16) long long unit_lanes[2];
+    alignas(16) int empty_lanes[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(unit_lanes), units);
+    _mm_store_si128(reinterpret_cast<__m128i*>(empty_lanes), empty);
+    CellTotals totals = sumCellsScalar(cells + i, count - i);
+    totals.units += unit_lanes[0] + unit_lanes[1];
+    long long empties = static_cast<long long>(empty_lanes[0]) + empty_lanes[1] + empty_lanes[2] + empty_lanes[3];
+    totals.occupied += static_cast<long long>(i) - empties;
+    return totals;
+}
+
+__attribute__((target("sse2")))
+inline size_t markCellsSse2(const int* cells, size_t count, bool empty, uint64_t* bits) {
+    const __m128i zero = _mm_setzero_si128();
+    uint64_t flip = empty ? 0 : ~uint64_t(0);
+    size_t marked = 0;
+    size_t w = 0;
+    for (; (w + 1) * 64 <= count; ++w) {
+        uint64_t word = 0;
+        const int* block = cells + w * 64;
+        for (int k = 0; k < 16; ++k) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 4 * k));
+            uint64_t mask = static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, zero))));
+            word |= mask << (4 * k);
+        }
+        bits[w] = word ^ flip;
+        marked += static_cast<size_t>(__builtin_popcountll(bits[w]));
+    }
+    if (w * 64 < count) marked += markCellsScalar(cells + w * 64, count - w * 64, empty, bits + w);
+    return marked;
+}
+
+__attribute__((target("avx2")))
+inline CellTotals sumCellsAvx2(const int* cells, size_t count) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i units = zero;
+    __m256i empty = zero;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cells + i));
+        units = _mm256_add_epi64(units, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(v)));
+        units = _mm256_add_epi64(units, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(v, 1)));
+        empty = _mm256_sub_epi32(empty, _mm256_cmpeq_epi32(v, zero));
+    }
+    alignas(32) long long unit_lanes[4];
+    alignas(32) int empty_lanes[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(unit_lanes), units);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(empty_lanes), empty);
+    CellTotals totals = sumCellsScalar(cells + i, count - i);
+    long long empties = 0;
+    for (int lane = 0; lane < 4; ++lane) totals.units += unit_lanes[lane];
+    for (int lane = 0; lane < 8; ++lane) empties += empty_lanes[lane];
+    totals.occupied += static_cast<long long>(i) - empties;
+    return totals;
+}
+
+__attribute__((target("avx2")))
+inline size_t markCellsAvx2(const int* cells, size_t count, bool empty, uint64_t* bits) {
+    const __m256i zero = _mm256_setzero_si256();
+    uint64_t flip = empty ? 0 : ~uint64_t(0);
+    size_t marked = 0;
+    size_t w = 0;
+    for (; (w + 1) * 64 <= count; ++w) {
+        uint64_t word = 0;
+        const int* block = cells + w * 64;
+        for (int k = 0; k < 8; ++k) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 8 * k));
+            uint64_t mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, zero))));
+            word |= mask << (8 * k);
+        }
+        bits[w] = word ^ flip;
+        marked += static_cast<size_t>(__builtin_popcountll(bits[w]));
+    }
+    if (w * 64 < count) marked += markCellsScalar(cells + w * 64, count - w * 64, empty, bits + w);
+    return marked;
+}
+
+#endif
+
+// Лучший вариант для текущего процессора; определяется при первом вызове
+inline ScanKernel scanKernel() {
+#ifdef CELL_SCAN_X86
+    static const ScanKernel kernel = __builtin_cpu_supports("avx2") ? ScanKernel::AVX2
+                                     : __builtin_cpu_supports("sse2") ? ScanKernel::SSE2
+                                     : ScanKernel::SCALAR;
+    return kernel;
+#else
+    return ScanKernel::SCALAR;
+#endif
+}
+
+inline CellTotals sumCells(const int* cells, size_t count, ScanKernel kernel = scanKernel()) {
+    switch (kernel) {
+#ifdef CELL_SCAN_X86
+        case ScanKernel::AVX2: return sumCellsAvx2(cells, count);
+        case ScanKernel::SSE2: return sumCellsSse2(cells, count);
+#endif
+        default: return sumCellsScalar(cells, count);
+    }
+}
+
+inline size_t markCells(const int* cells, size_t count, bool empty, uint64_t* bits, ScanKernel kernel = scanKernel()) {
+    switch (kernel) {
+#ifdef CELL_SCAN_X86
+        case ScanKernel::AVX2: return markCellsAvx2(cells, count, empty, bits);
+        case ScanKernel::SSE2: return markCellsSse2(cells, count, empty, bits);
+#endif
+        default: return markCellsScalar(cells, count, empty, bits);
+    }
+}
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <cstddef>
+#include <vector>
+
+// Журнал отмены: записи изменений всех операций лежат подряд в одном массиве,
+// для каждой операции хранится только начало её записей. Отмена проходит записи
+// операции с конца и применяет обратные изменения, повтор - с начала и применяет
+// их снова, поэтому UNDO/REDO стоят столько, сколько изменений было в операции.
+//
+// Что значит "применить" и "отменить" запись, решает владелец журнала: undo/redo
+// получают функцию, которой передаётся каждая запись. Пока эти функции работают,
+// операция не открыта и новые записи в журнал не попадают.
+//
+// Журнал ограничен max_records записями: при переполнении старые операции
+// отбрасываются (контрольная точка), и отменить их уже нельзя
+template <typename Record>
+class Journal {
+private:
+    std::vector<Record> records;
+    std::vector<size_t> starts;  // начало записей каждой операции
+    size_t done = 0;             // операции до done применены, после - доступны для REDO
+    size_t open_start = 0;
+    bool open = false;
+    size_t max_records;
+
+    size_t end(size_t operation) const {
+        return operation + 1 < starts.size() ? starts[operation + 1] : records.size();
+    }
+
+    // Контрольная точка: остаётся не больше половины лимита, но хотя бы последняя операция
+    void checkpoint() {
+        if (records.size() <= max_records) return;
+        size_t keep = starts.size() - 1;
+        while (keep > 0 && records.size() - starts[keep - 1] <= max_records / 2) --keep;
+        size_t dropped = starts[keep];
+        records.erase(records.begin(), records.begin() + dropped);
+        starts.erase(starts.begin(), starts.begin() + keep);
+        for (size_t& start : starts) start -= dropped;
+        done -= keep;
+    }
+
+public:
+    explicit Journal(size_t max_records) : max_records(max_records) {}
+
+    bool isOpen() const {
+        return open;
+    }
+
+    // Новая операция. Её записи идут после отменённых операций: те остаются
+    // доступны для REDO, пока операция не зафиксирована
+    void begin() {
+        open_start = records.size();
+        open = true;
+    }
+
+    void record(const Record& change) {
+        if (open) records.push_back(change);
+    }
+
+    // Закрывает операцию; операция без изменений в журнал не попадает.
+    // Зафиксированная операция вытесняет отменённые: повторить их уже нельзя
+    void commit() {
+        open = false;
+        if (records.size() == open_start) return;
+        if (done < starts.size()) {
+            size_t redo_start = starts[done];
+            records.erase(records.begin() + static_cast<std::ptrdiff_t>(redo_start),
+                          records.begin() + static_cast<std::ptrdiff_t>(open_start));
+            starts.resize(done);
+            open_start = redo_start;
+        }
+        starts.push_back(open_start);
+        done = starts.size();
+        checkpoint();
+    }
+
+    // Отменяет открытую операцию и забывает её
+    template <typename Revert>
+    void rollback(Revert revert) {
+        open = false;
+        for (size_t i = records.size(); i > open_start; --i) {
+            revert(records[i - 1]);
+        }
+        records.resize(open_start);
+    }
+
+    // Отменяет последнюю применённую операцию; возвращает число её записей или 0
+    template <typename Revert>
+    size_t undo(Revert revert) {
+        if (open || done == 0) return 0;
+        --done;
+        for (size_t i = end(done); i > starts[done]; --i) {
+            revert(records[i - 1]);
+        }
+        return end(done) - starts[done];
+    }
+
+    // Повторяет последнюю отменённую операцию; возвращает число её записей или 0
+    template <typename Apply>
+    size_t redo(Apply apply) {
+        if (open || done == starts.size()) return 0;
+        for (size_t i = starts[done]; i < end(done); ++i) {
+            apply(records[i]);
+        }
+        ++done;
+        return end(done - 1) - starts[done - 1];
+    }
+};
+
+#endif
@@ -0,0 +1,176 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <unistd.h>
+
+// Запись буфера в файл целиком; false, если запись прервалась
+inline bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written <= 0) return false;
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+// Число с фиксированным количеством знаков после запятой,
+// аналог cout << fixed << setprecision(digits) << value
+struct Fixed {
+    double value;
+    int digits;
+};
+
+// Буферизованный вывод без сброса на каждой строке.
+// В интерактивном режиме буфер сбрасывается перед ожиданием ввода
+// (flushIfInteractive), в пакетном - только при заполнении и в конце работы.
+// Программы без собственного приглашения (Task3, Task4) ждут команду через
+// promptInput: с ключом --prompt P перед каждой командой печатается P и вывод
+// сбрасывается, так замерщик (bench/runner) видит конец ответа на команду.
+// Перед каждой записью в файл вызывается before_flush, если он задан: так склад
+// с журналом на диске фиксирует операции до того, как клиент увидит ответ о них.
+// Если before_flush вернул false, накопленный вывод отбрасывается и не уходит клиенту
+class Output {
+public:
+    using FlushHook = bool (*)(void* context);
+
+private:
+    static constexpr size_t BUFFER_SIZE = 1 << 16;
+
+    int fd;
+    bool interactive;
+    size_t used = 0;
+    FlushHook before_flush = nullptr;
+    void* hook_context = nullptr;
+    std::string prompt;
+    char buffer[BUFFER_SIZE];
+
+    void writeAll(const char* data, size_t size) {
+        ::writeAll(fd, data, size);
+    }
+
+    template <typename T>
+    Output& writeNumber(T value) {
+        if (BUFFER_SIZE - used < 32) flush();
+        auto result = std::to_chars(buffer + used, buffer + BUFFER_SIZE, value);
+        used = static_cast<size_t>(result.ptr - buffer);
+        return *this;
+    }
+
+public:
+    explicit Output(int descriptor) : fd(descriptor), interactive(isatty(STDIN_FILENO) != 0) {}
+
+    Output(const Output&) = delete;
+    Output& operator=(const Output&) = delete;
+
+    ~Output() {
+        flush();
+    }
+
+    void setInteractive(bool value) {
+        interactive = value;
+    }
+
+    bool isInteractive() const {
+        return interactive;
+    }
+
+    void setBeforeFlush(FlushHook hook, void* context) {
+        before_flush = hook;
+        hook_context = context;
+    }
+
+    void flush() {
+        if (used == 0) return;
+        if (!before_flush || before_flush(hook_context)) writeAll(buffer, used);
+        used = 0;
+    }
+
+    void flushIfInteractive() {
+        if (interactive) flush();
+    }
+
+    void setPrompt(std::string text) {
+        prompt = std::move(text);
+    }
+
+    void promptInput() {
+        if (prompt.empty()) {
+            flushIfInteractive();
+            return;
+        }
+        *this << prompt;
+        flush();
+    }
+
+    Output& operator<<(std::string_view text) {
+        if (text.size() > BUFFER_SIZE - used) {
+            flush();
+            if (text.size() > BUFFER_SIZE) {
+                if (!before_flush || before_flush(hook_context)) writeAll(text.data(), text.size());
+                return *this;
+            }
+        }
+        std::memcpy(buffer + used, text.data(), text.size());
+        used += text.size();
+        return *this;
+    }
+
+    Output& operator<<(const std::string& text) {
+        return *this << std::string_view(text);
+    }
+
+    Output& operator<<(const char* text) {
+        return *this << std::string_view(text);
+    }
+
+    Output& operator<<(char c) {
+        if (used == BUFFER_SIZE) flush();
+        buffer[used++] = c;
+        return *this;
+    }
+
+    Output& operator<<(int value) { return writeNumber(value); }
+    Output& operator<<(long value) { return writeNumber(value); }
+    Output& operator<<(long long value) { return writeNumber(value); }
+    Output& operator<<(unsigned value) { return writeNumber(value); }
+    Output& operator<<(unsigned long value) { return writeNumber(value); }
+    Output& operator<<(unsigned long long value) { return writeNumber(value); }
+
+    // Длина числа заранее неизвестна (1e300 - больше 300 знаков): если оно не поместилось
+    // в остаток буфера, буфер сбрасывается и число форматируется заново с начала буфера
+    Output& operator<<(Fixed number) {
+        int written = std::snprintf(buffer + used, BUFFER_SIZE - used, "%.*f", number.digits, number.value);
+        if (written < 0) return *this;
+        if (static_cast<size_t>(written) >= BUFFER_SIZE - used) {
+            flush();
+            written = std::snprintf(buffer, BUFFER_SIZE, "%.*f", number.digits, number.value);
+            if (written < 0) return *this;
+        }
+        used += std::min(static_cast<size_t>(written), BUFFER_SIZE - 1 - used);
+        return *this;
+    }
+};
+
+// Общий вывод программы в stdout
+inline Output out(STDOUT_FILENO);
+
+// Разбор ключей --batch / --interactive и --prompt P; без ключа режим
+// определяется по терминалу
+inline void configureOutput(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--batch") out.setInteractive(false);
+        if (arg == "--interactive") out.setInteractive(true);
+        if (arg == "--prompt" && i + 1 < argc) out.setPrompt(argv[++i]);
+    }
+}
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Пул потоков с перехватом задач (work stealing). У каждого потока своя очередь:
+// свои задачи он берёт с конца, а опустев, забирает самые старые задачи из начала
+// чужих очередей. Задачи, поставленные из потока пула, попадают в его очередь,
+// остальные раскладываются по очередям по кругу. Очереди защищены собственными
+// мьютексами, поэтому потоки конкурируют только при перехвате.
+class ThreadPool {
+private:
+    using Task = std::function<void()>;
+
+    struct Worker {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    // Пул текущего потока и его номер в пуле; вне пула owner == nullptr
+    static inline thread_local const ThreadPool* owner = nullptr;
+    static inline thread_local size_t self = 0;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::atomic<size_t> queued{0};   // задачи в очередях
+    std::atomic<size_t> pending{0};  // поставленные, но не завершённые задачи
+    std::atomic<size_t> next{0};
+    std::mutex idle_lock;
+    std::condition_variable wake;
+    std::condition_variable done;
+    bool stopping = false;
+
+    bool take(size_t index, Task& task) {
+        // Своя очередь - с конца: последняя задача ещё в кеше
+        {
+            Worker& worker = *workers[index];
+            std::lock_guard<std::mutex> guard(worker.lock);
+            if (!worker.tasks.empty()) {
+                task = std::move(worker.tasks.back());
+                worker.tasks.pop_back();
+                return true;
+            }
+        }
+        for (size_t k = 1; k < workers.size(); ++k) {
+            Worker& victim = *workers[(index + k) % workers.size()];
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void run(size_t index) {
+        owner = this;
+        self = index;
+        Task task;
+        while (true) {
+            if (take(index, task)) {
+                queued.fetch_sub(1);
+                task();
+                task = nullptr;
+                if (pending.fetch_sub(1) == 1) {
+                    std::lock_guard<std::mutex> guard(idle_lock);
+                    done.notify_all();
+                }
+                continue;
+            }
+            std::unique_lock<std::mutex> guard(idle_lock);
+            wake.wait(guard, [this] { return stopping || queued.load() > 0; });
+            if (stopping && queued.load() == 0) return;
+        }
+    }
+
+public:
+    explicit ThreadPool(size_t count = std::thread::hardware_concurrency()) {
+        if (count == 0) count = 1;
+        for (size_t i = 0; i < count; ++i) {
+            workers.push_back(std::make_unique<Worker>());
+        }
+        for (size_t i = 0; i < count; ++i) {
+            threads.emplace_back([this, i] { run(i); });
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Оставшиеся задачи выполняются до остановки потоков
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> guard(idle_lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    size_t size() const {
+        return workers.size();
+    }
+
+    void submit(Task task) {
+        size_t index = owner == this ? self : next.fetch_add(1) % workers.size();
+        pending.fetch_add(1);
+        {
+            Worker& worker = *workers[index];
+            std::lock_guard<std::mutex> guard(worker.lock);
+            worker.tasks.push_back(std::move(task));
+        }
+        queued.fetch_add(1);
+        std::lock_guard<std::mutex> guard(idle_lock);
+        wake.notify_one();
+    }
+
+    // Ожидание всех поставленных задач, включая поставленные самими задачами;
+    // вызывается не из потока пула
+    void wait() {
+        std::unique_lock<std::mutex> guard(idle_lock);
+        done.wait(guard, [this] { return pending.load() == 0; });
+    }
+};
+
+#endif
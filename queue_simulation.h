@@ -0,0 +1,197 @@
+#ifndef QUEUE_SIMULATION_H
+#define QUEUE_SIMULATION_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "pool.h"
+
+// Моделирование очереди методом Монте-Карло: для каждого числа окон из диапазона
+// прогоняется days случайных дней по visitors посетителей. Все посетители дня
+// стоят в очереди с открытия и распределяются как в distribute_queue: в наименее
+// загруженное окно, при равной загрузке - в окно с меньшим номером. Ожидание
+// посетителя - время от открытия до начала его обслуживания.
+//
+// День с номером d при любом числе окон и любом числе потоков получает один и тот
+// же поток посетителей (зерно - пара seed, d), поэтому числа окон сравниваются на
+// одинаковых днях, а результат не зависит от числа потоков.
+enum class Distribution {
+    EXPONENTIAL,
+    UNIFORM
+};
+
+struct SimulationConfig {
+    int windows_from = 1;
+    int windows_to = 8;
+    int days = 1000;
+    int visitors = 200;
+    double mean = 10;  // средняя длительность обслуживания, минуты
+    Distribution distribution = Distribution::EXPONENTIAL;
+    uint64_t seed = 1;
+    size_t threads = std::thread::hardware_concurrency();
+};
+
+// Число посетителей по минутам ожидания; ожидания от WAIT_LIMIT минут попадают в последнюю ячейку
+class WaitCounts {
+private:
+    static constexpr size_t WAIT_LIMIT = 1 << 20;
+
+    std::vector<uint64_t> counts;
+    uint64_t samples = 0;
+
+public:
+    void add(long long wait) {
+        size_t index = std::min(static_cast<size_t>(wait), WAIT_LIMIT - 1);
+        if (index >= counts.size()) counts.resize(index + 1);
+        ++counts[index];
+        ++samples;
+    }
+
+    void merge(const WaitCounts& other) {
+        if (other.counts.size() > counts.size()) counts.resize(other.counts.size());
+        for (size_t i = 0; i < other.counts.size(); ++i) counts[i] += other.counts[i];
+        samples += other.samples;
+    }
+
+    uint64_t count() const {
+        return samples;
+    }
+
+    bool operator==(const WaitCounts& other) const {
+        return samples == other.samples && counts == other.counts;
+    }
+
+    long long percentile(double fraction) const {
+        if (samples == 0) return 0;
+        uint64_t rank = std::min(samples - 1, static_cast<uint64_t>(fraction * static_cast<double>(samples)));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts.size(); ++i) {
+            seen += counts[i];
+            if (seen > rank) return static_cast<long long>(i);
+        }
+        return static_cast<long long>(counts.size()) - 1;
+    }
+};
+
+// Итоги по одному числу окон
+struct WindowsResult {
+    int windows = 0;
+    std::vector<long long> makespans;  // максимальная загрузка окна по дням
+    long long busy = 0;                // суммарное время обслуживания
+    long long open = 0;                // суммарное время работы окон: окна * makespan
+    WaitCounts waits;
+
+    // Доля времени работы окон, занятая обслуживанием
+    double utilization() const {
+        return open > 0 ? static_cast<double>(busy) / static_cast<double>(open) : 0;
+    }
+
+    double average_makespan() const {
+        long long total = 0;
+        for (long long value : makespans) total += value;
+        return makespans.empty() ? 0 : static_cast<double>(total) / static_cast<double>(makespans.size());
+    }
+
+    // Перцентиль по дням; makespans должны быть отсортированы
+    long long makespan_percentile(double fraction) const {
+        if (makespans.empty()) return 0;
+        size_t index = std::min(makespans.size() - 1, static_cast<size_t>(fraction * static_cast<double>(makespans.size())));
+        return makespans[index];
+    }
+};
+
+// Длительности обслуживания посетителей дня day, целые минуты не меньше 1
+inline void generate_day(const SimulationConfig& config, int day, std::vector<int>& durations) {
+    std::seed_seq seeds{static_cast<uint32_t>(config.seed), static_cast<uint32_t>(config.seed >> 32),
+                        static_cast<uint32_t>(day)};
+    std::mt19937_64 rng(seeds);
+    durations.resize(static_cast<size_t>(config.visitors));
+    if (config.distribution == Distribution::EXPONENTIAL) {
+        std::exponential_distribution<double> duration(1.0 / config.mean);
+        for (int& value : durations) value = std::max(1, static_cast<int>(std::lround(duration(rng))));
+    } else {
+        int longest = std::max(1, static_cast<int>(std::lround(2 * config.mean)) - 1);
+        std::uniform_int_distribution<int> duration(1, longest);
+        for (int& value : durations) value = duration(rng);
+    }
+}
+
+// Распределение одного дня по windows_count окнам - то же, что distribute_queue, но без
+// талонов и копирования посетителей: куча хранит только (загрузка, номер окна).
+// Ожидания посетителей добавляются в waits, возвращается максимальная загрузка окна
+inline long long simulate_day(const std::vector<int>& durations, int windows_count,
+                              std::vector<std::pair<long long, int>>& heap, WaitCounts& waits) {
+    heap.clear();
+    for (int i = 0; i < windows_count; ++i) heap.push_back({0, i});
+    // Загрузки равны нулю, номера возрастают - вектор уже min-куча
+    std::greater<std::pair<long long, int>> later;
+    long long result = 0;
+    for (int duration : durations) {
+        std::pop_heap(heap.begin(), heap.end(), later);
+        std::pair<long long, int>& window = heap.back();
+        waits.add(window.first);
+        window.first += duration;
+        result = std::max(result, window.first);
+        std::push_heap(heap.begin(), heap.end(), later);
+    }
+    return result;
+}
+
+// Прогон всех дней и чисел окон на пуле потоков. Задача - группа подряд идущих дней:
+// поток посетителей генерируется один раз и прогоняется для каждого числа окон
+inline std::vector<WindowsResult> simulate_queue(const SimulationConfig& config) {
+    int counts = config.windows_to - config.windows_from + 1;
+    std::vector<WindowsResult> results(static_cast<size_t>(std::max(counts, 0)));
+    for (int i = 0; i < counts; ++i) {
+        results[i].windows = config.windows_from + i;
+        results[i].makespans.resize(static_cast<size_t>(config.days));
+    }
+
+    ThreadPool pool(config.threads);
+    // Задач с запасом на каждый поток, чтобы перехват выравнивал неровную нагрузку
+    int chunk = std::max(1, config.days / static_cast<int>(pool.size() * 16));
+    std::mutex merge_lock;
+    for (int first = 0; first < config.days; first += chunk) {
+        int last = std::min(config.days, first + chunk);
+        pool.submit([&config, &results, &merge_lock, counts, first, last] {
+            std::vector<int> durations;
+            std::vector<std::pair<long long, int>> heap;
+            std::vector<WaitCounts> waits(static_cast<size_t>(counts));
+            std::vector<long long> busy(static_cast<size_t>(counts), 0);
+            std::vector<long long> open(static_cast<size_t>(counts), 0);
+            for (int day = first; day < last; ++day) {
+                generate_day(config, day, durations);
+                long long total = 0;
+                for (int duration : durations) total += duration;
+                for (int i = 0; i < counts; ++i) {
+                    long long makespan = simulate_day(durations, results[i].windows, heap, waits[i]);
+                    // Каждая задача пишет только свои дни
+                    results[i].makespans[day] = makespan;
+                    busy[i] += total;
+                    open[i] += makespan * results[i].windows;
+                }
+            }
+            // Суммы целые, поэтому итог не зависит от порядка слияния
+            std::lock_guard<std::mutex> guard(merge_lock);
+            for (int i = 0; i < counts; ++i) {
+                results[i].busy += busy[i];
+                results[i].open += open[i];
+                results[i].waits.merge(waits[i]);
+            }
+        });
+    }
+    pool.wait();
+
+    for (WindowsResult& result : results) {
+        std::sort(result.makespans.begin(), result.makespans.end());
+    }
+    return results;
+}
+
+#endif
@@ -0,0 +1,360 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "output.h"
+
+// Счётчики и гистограммы времени команд по фазам:
+//   PARSE    - разбор строки и аргументов;
+//   VALIDATE - проверка аргументов по состоянию (адрес, остаток, номер);
+//   APPLY    - изменение состояния или вычисление ответа;
+//   PRINT    - формирование вывода.
+//
+// Команда замеряется объектом StatTimer на время обработки строки, границы фаз
+// отмечает statPhase() в любом месте кода, в том числе внутри классов, которые о
+// таймере не знают. Фазы, которые команда не проходит, в таблицу не попадают.
+//
+// Число команд считается точно, а по фазам замеряется каждая sample-я команда
+// (--stats-sample, по умолчанию каждая 16-я): отметка времени стоит десятки
+// наносекунд, и замер каждой команды заметно замедлил бы короткие ADD/REMOVE.
+// Ключ --no-stats и команда STATS OFF выключают статистику во время работы,
+// тогда таймер сводится к проверке флага. При сборке с -DNO_STATS код замеров
+// исчезает целиком, а STATS сообщает, что статистики нет.
+enum class Phase {
+    PARSE,
+    VALIDATE,
+    APPLY,
+    PRINT
+};
+
+constexpr int PHASE_COUNT = 4;
+
+inline const char* phaseName(Phase phase) {
+    static const char* const names[PHASE_COUNT] = {"parse", "validate", "apply", "print"};
+    return names[static_cast<int>(phase)];
+}
+
+// Отметка времени: счётчик тактов процессора, где он есть (он вдвое дешевле
+// steady_clock), иначе наносекунды steady_clock
+inline uint64_t statTicks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// Наносекунд в такте; частота счётчика измеряется один раз, при первом выводе таблицы
+inline double nanosPerTick() {
+#if defined(__x86_64__) || defined(__i386__)
+    static const double value = [] {
+        using Clock = std::chrono::steady_clock;
+        Clock::time_point start = Clock::now();
+        uint64_t first = statTicks();
+        while (Clock::now() - start < std::chrono::milliseconds(5)) {}
+        double nanos = static_cast<double>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+        return nanos / static_cast<double>(statTicks() - first);
+    }();
+    return value;
+#else
+    return 1.0;
+#endif
+}
+
+// Гистограмма длительностей в тактах с логарифмическими корзинами: каждая
+// степень двойки делится на SUB_BUCKETS частей, поэтому оценка перцентиля
+// ошибается не больше чем на четверть значения
+class Histogram {
+private:
+    static constexpr int SUB_BITS = 2;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BITS;
+    static constexpr int BUCKET_COUNT = 64 * SUB_BUCKETS;
+
+    std::array<uint64_t, BUCKET_COUNT> buckets{};
+    uint64_t samples = 0;
+    uint64_t total = 0;
+    uint64_t longest = 0;
+
+    static int bucketOf(uint64_t value) {
+        if (value < SUB_BUCKETS) return static_cast<int>(value);
+        int octave = 63 - __builtin_clzll(value);
+        int sub = static_cast<int>(value >> (octave - SUB_BITS)) & (SUB_BUCKETS - 1);
+        return (octave - SUB_BITS + 1) * SUB_BUCKETS + sub;
+    }
+
+    // Верхняя граница корзины
+    static uint64_t limitOf(int bucket) {
+        if (bucket < SUB_BUCKETS) return static_cast<uint64_t>(bucket);
+        int octave = bucket / SUB_BUCKETS + SUB_BITS - 1;
+        uint64_t sub = static_cast<uint64_t>(bucket % SUB_BUCKETS);
+        return ((SUB_BUCKETS + sub + 1) << (octave - SUB_BITS)) - 1;
+    }
+
+public:
+    void add(uint64_t value) {
+        ++buckets[bucketOf(value)];
+        ++samples;
+        total += value;
+        if (value > longest) longest = value;
+    }
+
+    uint64_t count() const { return samples; }
+    uint64_t sum() const { return total; }
+    uint64_t max() const { return longest; }
+
+    uint64_t percentile(double fraction) const {
+        if (samples == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(fraction * static_cast<double>(samples));
+        if (rank >= samples) rank = samples - 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKET_COUNT; ++i) {
+            seen += buckets[i];
+            if (seen > rank) return limitOf(i) < longest ? limitOf(i) : longest;
+        }
+        return longest;
+    }
+};
+
+class Stats {
+private:
+    std::vector<std::string> names;
+    std::vector<uint64_t> counts;
+    std::vector<std::array<Histogram, PHASE_COUNT>> table;
+    bool enabled = true;
+    unsigned sample_every = 16;
+    unsigned until_sample = 1;
+
+    std::string dump_path;
+    std::chrono::steady_clock::duration dump_interval = std::chrono::seconds(10);
+    std::chrono::steady_clock::time_point last_dump = std::chrono::steady_clock::now();
+
+    static void printTime(Output& sink, uint64_t ticks) {
+        sink << Fixed{static_cast<double>(ticks) * nanosPerTick() / 1000, 2};
+    }
+
+public:
+    Stats() = default;
+    Stats(const Stats&) = delete;
+    Stats& operator=(const Stats&) = delete;
+
+    // Последняя выгрузка при завершении программы
+    ~Stats() {
+        if (!dump_path.empty()) dump();
+    }
+
+    // Имена команд в порядке их номеров (значений перечисления команд программы)
+    void setCommands(std::vector<std::string> command_names) {
+        names = std::move(command_names);
+        reset();
+    }
+
+    bool isEnabled() const {
+        return enabled;
+    }
+
+    void setEnabled(bool value) {
+        enabled = value;
+    }
+
+    void setSample(unsigned every) {
+        sample_every = every > 0 ? every : 1;
+        until_sample = 1;
+    }
+
+    void reset() {
+        counts.assign(names.size(), 0);
+        table.assign(names.size(), {});
+    }
+
+    // Замерять ли фазы очередной команды
+    bool sampleNext() {
+        if (!enabled || --until_sample > 0) return false;
+        until_sample = sample_every;
+        return true;
+    }
+
+    void count(int command) {
+        if (enabled && command >= 0 && static_cast<size_t>(command) < counts.size()) ++counts[command];
+    }
+
+    void record(int command, const std::array<uint64_t, PHASE_COUNT>& phases, unsigned seen) {
+        if (command < 0 || static_cast<size_t>(command) >= table.size()) return;
+        for (int phase = 0; phase < PHASE_COUNT; ++phase) {
+            if (seen & (1u << phase)) table[command][phase].add(phases[phase]);
+        }
+    }
+
+    // Таблица: команда, фаза, число команд, число замеров, среднее, p50, p99
+    // и максимум в микросекундах
+    void print(Output& sink) const {
+        sink << "command phase count sampled avg_us p50_us p99_us max_us" << '\n';
+        for (size_t command = 0; command < table.size(); ++command) {
+            for (int phase = 0; phase < PHASE_COUNT; ++phase) {
+                const Histogram& h = table[command][phase];
+                if (h.count() == 0) continue;
+                sink << names[command] << ' ' << phaseName(static_cast<Phase>(phase)) << ' '
+                     << counts[command] << ' ' << h.count() << ' ';
+                printTime(sink, h.sum() / h.count());
+                sink << ' ';
+                printTime(sink, h.percentile(0.5));
+                sink << ' ';
+                printTime(sink, h.percentile(0.99));
+                sink << ' ';
+                printTime(sink, h.max());
+                sink << '\n';
+            }
+        }
+    }
+
+    void setDump(std::string path, std::chrono::steady_clock::duration interval) {
+        dump_path = std::move(path);
+        dump_interval = interval;
+    }
+
+    // Запись таблицы в файл: во временный, затем rename, чтобы читатель не видел половину
+    void dump() {
+        last_dump = std::chrono::steady_clock::now();
+        if (dump_path.empty()) return;
+        std::string temporary = dump_path + ".tmp";
+        int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) return;
+        {
+            Output file(fd);
+            print(file);
+        }
+        ::close(fd);
+        ::rename(temporary.c_str(), dump_path.c_str());
+    }
+
+    // Периодическая выгрузка; вызывается между командами
+    void tick() {
+        if (!dump_path.empty() && std::chrono::steady_clock::now() - last_dump >= dump_interval) dump();
+    }
+};
+
+// Общая статистика программы
+inline Stats stats;
+
+#ifndef NO_STATS
+
+// Замер одной команды. Номер команды задаётся после разбора; команда без номера не
+// записывается. Длительности фаз копятся в таймере и попадают в stats при его разрушении
+class StatTimer {
+private:
+    static inline thread_local StatTimer* current = nullptr;
+
+    StatTimer* previous = nullptr;
+    bool active;
+    int command_id = -1;
+    Phase phase = Phase::PARSE;
+    unsigned seen = 0;
+    uint64_t started = 0;
+    std::array<uint64_t, PHASE_COUNT> phases{};
+
+    void close(uint64_t now) {
+        phases[static_cast<int>(phase)] += now - started;
+        seen |= 1u << static_cast<int>(phase);
+        started = now;
+    }
+
+public:
+    StatTimer() : active(stats.sampleNext()) {
+        if (!active) return;
+        previous = current;
+        current = this;
+        started = statTicks();
+    }
+
+    StatTimer(const StatTimer&) = delete;
+    StatTimer& operator=(const StatTimer&) = delete;
+
+    ~StatTimer() {
+        if (!active) return;
+        close(statTicks());
+        current = previous;
+        stats.record(command_id, phases, seen);
+    }
+
+    void command(int id) {
+        command_id = id;
+        stats.count(id);
+    }
+
+    void enter(Phase next) {
+        if (!active || next == phase) return;
+        close(statTicks());
+        phase = next;
+    }
+
+    static StatTimer* activeTimer() {
+        return current;
+    }
+};
+
+// Граница фазы текущей команды; без замеряемой команды ничего не делает
+inline void statPhase(Phase phase) {
+    if (StatTimer* timer = StatTimer::activeTimer()) timer->enter(phase);
+}
+
+#else
+
+class StatTimer {
+public:
+    void command(int) {}
+    void enter(Phase) {}
+};
+
+inline void statPhase(Phase) {}
+
+#endif
+
+// Ключи статистики: --no-stats выключает её, --stats-sample <n> замеряет фазы
+// каждой n-й команды, --stats-file <файл> включает периодическую выгрузку
+// таблицы, --stats-interval <секунды> задаёт её период
+inline void configureStats(int argc, char* argv[]) {
+    std::string path;
+    long seconds = 10;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--no-stats") stats.setEnabled(false);
+        else if (arg == "--stats-sample" && i + 1 < argc) stats.setSample(static_cast<unsigned>(std::atoi(argv[++i])));
+        else if (arg == "--stats-file" && i + 1 < argc) path = argv[++i];
+        else if (arg == "--stats-interval" && i + 1 < argc) seconds = std::strtol(argv[++i], nullptr, 10);
+    }
+    if (seconds <= 0) seconds = 1;
+#ifndef NO_STATS
+    stats.setDump(path, std::chrono::seconds(seconds));
+#endif
+}
+
+// Команда STATS [ON|OFF|RESET]; без аргумента печатает таблицу.
+// Возвращает false, если аргумент не распознан
+inline bool statsCommand(std::string_view argument, Output& sink) {
+#ifdef NO_STATS
+    (void)argument;
+    sink << "statistics compiled out (NO_STATS)" << '\n';
+    return true;
+#else
+    if (argument.empty()) stats.print(sink);
+    else if (argument == "ON") stats.setEnabled(true);
+    else if (argument == "OFF") stats.setEnabled(false);
+    else if (argument == "RESET") stats.reset();
+    else return false;
+    return true;
+#endif
+}
+
+#endif
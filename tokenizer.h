@@ -0,0 +1,88 @@
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+#include <charconv>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <string_view>
+
+// Хеш FNV-1a для слова команды. Функция constexpr, поэтому значения
+// для известных команд используются прямо как метки case в switch:
+//
+//     switch (commandHash(word)) {
+//         case commandHash("ADD"): ...
+//
+// Хеши разных слов могут совпасть, поэтому внутри case слово нужно сверить целиком.
+constexpr uint32_t commandHash(std::string_view word) {
+    uint32_t hash = 2166136261u;
+    for (char c : word) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Разбор строки на слова без выделения памяти: токены - это string_view
+// внутрь строки, которую вызывающий код переиспользует между командами
+class Tokenizer {
+private:
+    std::string_view rest;
+
+    static bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    void skipSpaces() {
+        size_t i = 0;
+        while (i < rest.size() && isSpace(rest[i])) ++i;
+        rest.remove_prefix(i);
+    }
+
+public:
+    explicit Tokenizer(std::string_view line) : rest(line) {
+        skipSpaces();
+    }
+
+    // Следующее слово или пустая строка, если слов больше нет
+    std::string_view next() {
+        size_t i = 0;
+        while (i < rest.size() && !isSpace(rest[i])) ++i;
+        std::string_view token = rest.substr(0, i);
+        rest.remove_prefix(i);
+        skipSpaces();
+        return token;
+    }
+
+    // Следующее слово как целое число; false, если слова нет или оно не целиком число
+    bool nextInt(int& value) {
+        std::string_view token = next();
+        if (token.empty()) return false;
+        const char* first = token.data();
+        const char* last = token.data() + token.size();
+        // Знак допускается один: после '+' from_chars принял бы ещё и '-'
+        if (*first == '+') {
+            ++first;
+            if (first != last && *first == '-') return false;
+        }
+        auto [ptr, ec] = std::from_chars(first, last, value);
+        return ec == std::errc() && ptr == last && first != last;
+    }
+
+    bool empty() const {
+        return rest.empty();
+    }
+
+    // Непрочитанная часть строки без ведущих пробелов
+    std::string_view remainder() const {
+        return rest;
+    }
+};
+
+// Чтение строки в переиспользуемый буфер: после первых строк память
+// буфера уже выделена, и getline только перезаписывает её
+inline bool readLine(std::istream& in, std::string& buffer) {
+    return static_cast<bool>(std::getline(in, buffer));
+}
+
+#endif
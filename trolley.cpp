@@ -1,91 +1,924 @@
 #include "trolley.h"
+#include "tokenizer.h"
+#include "output.h"
+#include "stats.h"
 #include <iostream>
 #include <algorithm>
+#include <stdexcept>
+#include <queue>
+#include <functional>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 using namespace std;
 
-void TrolleySystem::createTrolley(const string& name, const vector<string>& stopsList) {
-    trolleys[name] = stopsList;
+size_t NameTable::slotFor(string_view name) const {
+    size_t mask = slots.size() - 1;
+    size_t slot = commandHash(name) & mask;
+    while (slots[slot] >= 0 && this->name(slots[slot]) != name) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void NameTable::grow() {
+    vector<int> old(slots.begin(), slots.end());
+    slots.mutate().assign(old.empty() ? 16 : old.size() * 2, -1);
+    for (int id : old) {
+        if (id >= 0) slots.mutate()[slotFor(name(id))] = id;
+    }
+}
+
+int NameTable::find(string_view name) const {
+    if (slots.empty()) return -1;
+    return slots[slotFor(name)];
+}
+
+int NameTable::intern(string_view name) {
+    // Известное имя не трогает таблицу, поэтому не копирует загруженный снимок
+    int known = find(name);
+    if (known >= 0) return known;
+
+    // Таблица заполняется не более чем наполовину
+    if (static_cast<size_t>(size() + 1) * 2 > slots.size()) grow();
+    int id = size();
+    vector<char>& text = chars.mutate();
+    text.insert(text.end(), name.begin(), name.end());
+    offsets.mutate().push_back(static_cast<uint32_t>(text.size()));
+    slots.mutate()[slotFor(name)] = id;
+    return id;
+}
+
+string_view NameTable::name(int id) const {
+    return string_view(chars.data() + offsets[id], offsets[id + 1] - offsets[id]);
+}
+
+int NameTable::size() const {
+    return static_cast<int>(offsets.size()) - 1;
+}
+
+bool NameTable::valid() const {
+    if (offsets.empty() || offsets[0] != 0 || offsets[offsets.size() - 1] != chars.size()) return false;
+    size_t names = offsets.size() - 1;
+    for (size_t i = 0; i < names; ++i) {
+        if (offsets[i] > offsets[i + 1]) return false;
+    }
+    if (slots.empty()) return names == 0;
+    if ((slots.size() & (slots.size() - 1)) != 0 || names * 2 > slots.size()) return false;
+
+    // Каждый id лежит в таблице ровно один раз и находится по своему имени:
+    // таблица заполнена не больше чем наполовину, поэтому поиск всегда доходит до пустой ячейки
+    size_t stored = 0;
+    for (int id : slots) {
+        if (id < -1 || id >= static_cast<int>(names)) return false;
+        if (id >= 0) ++stored;
+    }
+    if (stored != names) return false;
+    for (size_t id = 0; id < names; ++id) {
+        if (find(name(static_cast<int>(id))) != static_cast<int>(id)) return false;
+    }
+    return true;
+}
 
-    for (const auto& stop : stopsList) {
-        stops[stop].push_back(name);
+void AdjacencyLists::resize(int lists) {
+    if (lists > static_cast<int>(blocks.size())) {
+        blocks.mutate().resize(lists, {static_cast<int>(data.size()), 0, 0});
     }
 }
 
-void TrolleySystem::trolleysForStop(const string& stop) const {
-    if (stops.empty()) {
-        cout << "Stops is absent" << endl;
+void AdjacencyLists::reserve(int list, int capacity) {
+    Block& block = blocks.mutate()[list];
+    if (block.capacity >= capacity) return;
+
+    vector<int>& values = data.mutate();
+    int offset = static_cast<int>(values.size());
+    values.resize(offset + capacity);
+    copy(values.begin() + block.offset, values.begin() + block.offset + block.size, values.begin() + offset);
+    garbage += block.capacity;
+    block.offset = offset;
+    block.capacity = capacity;
+
+    if (garbage > values.size() / 2) compact();
+}
+
+void AdjacencyLists::compact() {
+    vector<int>& values = data.mutate();
+    vector<int> packed;
+    packed.reserve(values.size() - garbage);
+    for (Block& block : blocks.mutate()) {
+        int offset = static_cast<int>(packed.size());
+        packed.insert(packed.end(), values.begin() + block.offset, values.begin() + block.offset + block.capacity);
+        block.offset = offset;
+    }
+    values = move(packed);
+    garbage = 0;
+}
+
+void AdjacencyLists::push(int list, int value) {
+    if (blocks[list].size == blocks[list].capacity) reserve(list, max(4, blocks[list].capacity * 2));
+    Block& block = blocks.mutate()[list];
+    data.mutate()[block.offset + block.size++] = value;
+}
+
+void AdjacencyLists::erase(int list, int value) {
+    Block& block = blocks.mutate()[list];
+    auto first = data.mutate().begin() + block.offset;
+    auto last = remove(first, first + block.size, value);
+    block.size = static_cast<int>(last - first);
+}
+
+void AdjacencyLists::assign(int list, const vector<int>& values) {
+    // Пустой список пустым и остаётся: такие вызовы не копируют загруженный снимок
+    if (values.empty() && blocks[list].size == 0) return;
+    reserve(list, static_cast<int>(values.size()));
+    Block& block = blocks.mutate()[list];
+    copy(values.begin(), values.end(), data.mutate().begin() + block.offset);
+    block.size = static_cast<int>(values.size());
+}
+
+int AdjacencyLists::size(int list) const {
+    return blocks[list].size;
+}
+
+IdRange AdjacencyLists::get(int list) const {
+    const Block& block = blocks[list];
+    const int* first = data.data() + block.offset;
+    return {first, first + block.size};
+}
+
+bool AdjacencyLists::validate(int lists, int limit) {
+    if (blocks.size() != static_cast<size_t>(lists)) return false;
+    size_t used = 0;
+    for (const Block& block : blocks) {
+        if (block.offset < 0 || block.size < 0 || block.size > block.capacity) return false;
+        if (static_cast<size_t>(block.offset) + block.capacity > data.size()) return false;
+        for (int i = 0; i < block.size; ++i) {
+            int value = data[block.offset + i];
+            if (value < 0 || value >= limit) return false;
+        }
+        used += block.capacity;
+    }
+    if (used > data.size()) return false;
+    garbage = data.size() - used;
+    return true;
+}
+
+void TrolleySystem::addMembership(int stop, int trolley) {
+    if (stopTrolleys.size(stop) == 0) ++activeStops;
+    stopTrolleys.push(stop, trolley);
+}
+
+void TrolleySystem::removeMembership(int stop, int trolley) {
+    stopTrolleys.erase(stop, trolley);
+    if (stopTrolleys.size(stop) == 0) --activeStops;
+}
+
+// Заменяет список остановок маршрута. Индекс остановок меняется только для
+// остановок, которые появились или исчезли; каждая остановка хранит маршрут один раз
+void TrolleySystem::setStops(int trolley, const vector<int>& newStops) {
+    oldMark.resize(stopNames.size(), 0);
+    newMark.resize(stopNames.size(), 0);
+    ++stamp;
+
+    IdRange oldStops = trolleyStops.get(trolley);
+    for (int stop : oldStops) {
+        oldMark[stop] = stamp;
+    }
+    for (int stop : newStops) {
+        if (newMark[stop] == stamp) continue;
+        newMark[stop] = stamp;
+        if (oldMark[stop] != stamp) addMembership(stop, trolley);
+    }
+    for (int stop : oldStops) {
+        if (newMark[stop] != stamp && oldMark[stop] == stamp) {
+            removeMembership(stop, trolley);
+            oldMark[stop] = 0;
+        }
+    }
+    bool sameStops = equal(oldStops.begin(), oldStops.end(), newStops.begin(), newStops.end());
+    trolleyStops.assign(trolley, newStops);
+    ++version;
+
+    // Расписание старого списка остановок больше не подходит
+    trolleyOffsets.resize(trolleyNames.size());
+    trolleyDepartures.resize(trolleyNames.size());
+    if (!sameStops) {
+        trolleyOffsets.assign(trolley, {});
+        trolleyDepartures.assign(trolley, {});
+    }
+}
+
+void TrolleySystem::createTrolley(string_view name, const vector<string_view>& stopsList) {
+    int trolley = trolleyNames.intern(name);
+    trolleyStops.resize(trolleyNames.size());
+    if (trolleyAlive.size() < static_cast<size_t>(trolleyNames.size())) {
+        trolleyAlive.mutate().resize(trolleyNames.size(), 0);
+    }
+
+    if (!trolleyAlive[trolley]) {
+        trolleyAlive.mutate()[trolley] = 1;
+        auto pos = lower_bound(trolleyOrder.begin(), trolleyOrder.end(), name,
+            [this](int id, string_view value) { return trolleyNames.name(id) < value; });
+        size_t index = static_cast<size_t>(pos - trolleyOrder.begin());
+        vector<int>& order = trolleyOrder.mutate();
+        order.insert(order.begin() + index, trolley);
+    }
+
+    ids.clear();
+    for (string_view stopName : stopsList) {
+        ids.push_back(stopNames.intern(stopName));
+    }
+    stopTrolleys.resize(stopNames.size());
+    setStops(trolley, ids);
+}
+
+bool TrolleySystem::updateTrolley(string_view name, const vector<string_view>& stopsList) {
+    statPhase(Phase::VALIDATE);
+    if (!isTrolleyExist(name)) return false;
+    statPhase(Phase::APPLY);
+    createTrolley(name, stopsList);
+    return true;
+}
+
+bool TrolleySystem::deleteTrolley(string_view name) {
+    statPhase(Phase::VALIDATE);
+    if (!isTrolleyExist(name)) return false;
+    statPhase(Phase::APPLY);
+    int trolley = trolleyNames.find(name);
+
+    ids.clear();
+    setStops(trolley, ids);
+    trolleyAlive.mutate()[trolley] = 0;
+    vector<int>& order = trolleyOrder.mutate();
+    order.erase(find(order.begin(), order.end(), trolley));
+    return true;
+}
+
+void TrolleySystem::trolleysForStop(string_view stop) const {
+    statPhase(Phase::VALIDATE);
+    if (activeStops == 0) {
+        out << "Stops is absent" << '\n';
         return;
     }
 
-    auto it = stops.find(stop);
-    if (it == stops.end()) {
-        cout << "Stop " << stop << ": 0" << endl;
+    int id = stopNames.find(stop);
+    if (id < 0 || stopTrolleys.size(id) == 0) {
+        out << "Stop " << stop << ": 0" << '\n';
         return;
     }
 
-    cout << stop << ": ";
-    for (size_t i = 0; i < it->second.size(); ++i) {
-        if (i != 0) cout << " ";
-        cout << it->second[i];
+    statPhase(Phase::PRINT);
+    out << stop << ": ";
+    bool first = true;
+    for (int trolley : stopTrolleys.get(id)) {
+        if (!first) out << " ";
+        out << trolleyNames.name(trolley);
+        first = false;
     }
-    cout << endl;
+    out << '\n';
 }
 
-void TrolleySystem::stopsForTrolley(const string& trolley) const {
-    if (trolleys.empty()) {
-        cout << "Trolleys is absent" << endl;
+void TrolleySystem::stopsForTrolley(string_view trolley) const {
+    statPhase(Phase::VALIDATE);
+    if (trolleyOrder.empty()) {
+        out << "Trolleys is absent" << '\n';
         return;
     }
 
-    auto it = trolleys.find(trolley);
-    if (it == trolleys.end()) {
-        cout << "Trolley " << trolley << " is absent" << endl;
+    int id = trolleyNames.find(trolley);
+    if (id < 0 || !trolleyAlive[id]) {
+        out << "Trolley " << trolley << " is absent" << '\n';
         return;
     }
 
-    for (const auto& stop : it->second) {
-        cout << "Stop " << stop << ": ";
+    statPhase(Phase::PRINT);
+    for (int stop : trolleyStops.get(id)) {
+        out << "Stop " << stopNames.name(stop) << ": ";
         bool first = true;
-        for (const auto& trl : stops.at(stop)) {
-            if (trl != trolley) {
-                if (!first) cout << " ";
-                cout << trl;
+        for (int trl : stopTrolleys.get(stop)) {
+            if (trl != id) {
+                if (!first) out << " ";
+                out << trolleyNames.name(trl);
                 first = false;
             }
         }
-        if (first) cout << "0";
-        cout << endl;
+        if (first) out << "0";
+        out << '\n';
     }
 }
 
 void TrolleySystem::allTrolleys() const {
-    if (trolleys.empty()) {
-        cout << "Trolleys is absent" << endl;
+    statPhase(Phase::PRINT);
+    if (trolleyOrder.empty()) {
+        out << "Trolleys is absent" << '\n';
+        return;
+    }
+
+    for (int trolley : trolleyOrder) {
+        out << "TRL " << trolleyNames.name(trolley) << ": ";
+        bool first = true;
+        for (int stop : trolleyStops.get(trolley)) {
+            if (!first) out << " ";
+            out << stopNames.name(stop);
+            first = false;
+        }
+        out << '\n';
+    }
+}
+
+bool TrolleySystem::isTrolleyExist(string_view name) const {
+    int id = trolleyNames.find(name);
+    return id >= 0 && trolleyAlive[id];
+}
+
+bool TrolleySystem::isStopExist(string_view name) const {
+    int id = stopNames.find(name);
+    return id >= 0 && stopTrolleys.size(id) > 0;
+}
+
+void TrolleySystem::buildJourneyGraph() const {
+    if (graphVersion == version) return;
+    graphVersion = version;
+    journeyCache.clear();
+    journeyCacheNext = 0;
+
+    positionStop.clear();
+    positionTrolley.clear();
+    routeStart.assign(trolleyNames.size(), 0);
+    for (int trolley : trolleyOrder) {
+        routeStart[trolley] = static_cast<int>(positionStop.size());
+        for (int stop : trolleyStops.get(trolley)) {
+            positionStop.push_back(stop);
+            positionTrolley.push_back(trolley);
+        }
+    }
+
+    // Таблица пересадок: для каждой остановки - все позиции маршрутов на ней
+    int stops = stopNames.size();
+    stopPositionOffsets.assign(stops + 1, 0);
+    for (int stop : positionStop) {
+        ++stopPositionOffsets[stop + 1];
+    }
+    for (int i = 0; i < stops; ++i) {
+        stopPositionOffsets[i + 1] += stopPositionOffsets[i];
+    }
+    stopPositions.resize(positionStop.size());
+    vector<int> fill(stopPositionOffsets.begin(), stopPositionOffsets.end() - 1);
+    for (size_t p = 0; p < positionStop.size(); ++p) {
+        stopPositions[fill[positionStop[p]]++] = static_cast<int>(p);
+    }
+}
+
+// Дейкстра по стоимости (посадки << 32) + перегоны. Вершины 0..S-1 - остановки,
+// S + p - позиция p на маршруте. Посадка стоит одну посадку, переезд - один перегон,
+// выход на остановку бесплатен
+const TrolleySystem::JourneyTree& TrolleySystem::journeyTree(int source) const {
+    for (const JourneyTree& tree : journeyCache) {
+        if (tree.source == source) return tree;
+    }
+
+    const uint64_t BOARDING = uint64_t(1) << 32;
+    const uint64_t INF = ~uint64_t(0);
+    int stops = stopNames.size();
+    int nodes = stops + static_cast<int>(positionStop.size());
+
+    JourneyTree tree{source, vector<uint64_t>(nodes, INF), vector<int>(nodes, -1)};
+    priority_queue<pair<uint64_t, int>, vector<pair<uint64_t, int>>, greater<pair<uint64_t, int>>> heap;
+    auto relax = [&](int node, uint64_t cost, int parent) {
+        if (cost < tree.cost[node]) {
+            tree.cost[node] = cost;
+            tree.parent[node] = parent;
+            heap.push({cost, node});
+        }
+    };
+
+    relax(source, 0, -1);
+    while (!heap.empty()) {
+        auto [cost, node] = heap.top();
+        heap.pop();
+        if (cost != tree.cost[node]) continue;
+
+        if (node < stops) {
+            for (int i = stopPositionOffsets[node]; i < stopPositionOffsets[node + 1]; ++i) {
+                relax(stops + stopPositions[i], cost + BOARDING, node);
+            }
+            continue;
+        }
+
+        int p = node - stops;
+        relax(positionStop[p], cost, node);
+        if (p > 0 && positionTrolley[p - 1] == positionTrolley[p]) {
+            relax(node - 1, cost + 1, node);
+        }
+        if (p + 1 < static_cast<int>(positionStop.size()) && positionTrolley[p + 1] == positionTrolley[p]) {
+            relax(node + 1, cost + 1, node);
+        }
+    }
+
+    if (journeyCache.size() < JOURNEY_CACHE_SIZE) {
+        journeyCache.push_back(move(tree));
+        return journeyCache.back();
+    }
+    size_t slot = journeyCacheNext;
+    journeyCacheNext = (journeyCacheNext + 1) % JOURNEY_CACHE_SIZE;
+    journeyCache[slot] = move(tree);
+    return journeyCache[slot];
+}
+
+bool TrolleySystem::findJourney(string_view from, string_view to, Journey& journey) const {
+    journey = Journey();
+    int source = stopNames.find(from);
+    int target = stopNames.find(to);
+    if (source < 0 || target < 0) return false;
+
+    buildJourneyGraph();
+    const JourneyTree& tree = journeyTree(source);
+    if (tree.cost[target] == ~uint64_t(0)) return true;
+
+    journey.found = true;
+    journey.stops = static_cast<int>(tree.cost[target] & 0xffffffffu);
+    int boardings = static_cast<int>(tree.cost[target] >> 32);
+    journey.transfers = max(0, boardings - 1);
+
+    // Путь восстанавливается с конца: участок - это цепочка позиций одного маршрута
+    int stops = stopNames.size();
+    int node = target;
+    while (node != source) {
+        int parent = tree.parent[node];
+        if (node < stops && parent >= stops) {
+            int boarded = parent;
+            while (tree.parent[boarded] >= stops) boarded = tree.parent[boarded];
+            int trolley = positionTrolley[parent - stops];
+            journey.legs.push_back({trolley, positionStop[boarded - stops], node, abs(parent - boarded)});
+            node = tree.parent[boarded];
+        } else {
+            node = parent;
+        }
+    }
+    reverse(journey.legs.begin(), journey.legs.end());
+    return true;
+}
+
+void TrolleySystem::route(string_view from, string_view to) const {
+    statPhase(Phase::APPLY);
+    Journey journey;
+    bool known = findJourney(from, to, journey);
+    statPhase(Phase::PRINT);
+    if (!known) {
+        out << "Stop " << (stopNames.find(from) < 0 ? from : to) << " is absent" << '\n';
+        return;
+    }
+    if (!journey.found) {
+        out << "Route " << from << " -> " << to << ": no path" << '\n';
         return;
     }
 
-    for (const auto& [name, stopsList] : trolleys) {
-        cout << "TRL " << name << ": ";
-        for (size_t i = 0; i < stopsList.size(); ++i) {
-            if (i != 0) cout << " ";
-            cout << stopsList[i];
+    out << "Route " << from << " -> " << to << ": " << journey.transfers << " transfers, "
+        << journey.stops << " stops" << '\n';
+    for (const JourneyLeg& leg : journey.legs) {
+        out << "TRL " << trolleyNames.name(leg.trolley) << ": " << stopNames.name(leg.from) << " -> "
+            << stopNames.name(leg.to) << " (" << leg.stops << " stops)" << '\n';
+    }
+}
+
+// Прибытие может быть позже 99:59, тогда часы печатаются всеми цифрами
+static void printTime(int minutes) {
+    int hours = minutes / 60;
+    if (hours < 10) out << '0';
+    out << hours << ':' << static_cast<char>('0' + minutes % 60 / 10) << static_cast<char>('0' + minutes % 10);
+}
+
+bool parseTime(string_view text, int& minutes) {
+    if (text.size() != 5 || text[2] != ':') return false;
+    for (int i : {0, 1, 3, 4}) {
+        if (text[i] < '0' || text[i] > '9') return false;
+    }
+    int hours = (text[0] - '0') * 10 + (text[1] - '0');
+    int mins = (text[3] - '0') * 10 + (text[4] - '0');
+    if (hours >= 48 || mins >= 60) return false;
+    minutes = hours * 60 + mins;
+    return true;
+}
+
+bool TrolleySystem::setSegmentTimes(string_view trolley, const vector<int>& minutes) {
+    statPhase(Phase::APPLY);
+    if (!isTrolleyExist(trolley)) return false;
+    int id = trolleyNames.find(trolley);
+    if (minutes.size() + 1 != trolleyStops.get(id).size()) return false;
+
+    ids.assign(1, 0);
+    for (int segment : minutes) {
+        if (segment <= 0) return false;
+        long long offset = static_cast<long long>(ids.back()) + segment;
+        if (offset >= MAX_SCHEDULE_MINUTES) return false;
+        ids.push_back(static_cast<int>(offset));
+    }
+    trolleyOffsets.assign(id, ids);
+    return true;
+}
+
+bool TrolleySystem::addDepartures(string_view trolley, const vector<int>& times) {
+    statPhase(Phase::APPLY);
+    if (!isTrolleyExist(trolley)) return false;
+    int id = trolleyNames.find(trolley);
+    // Те же границы, что проверяет LOAD: сохранённый снимок всегда загружается
+    for (int time : times) {
+        if (time < 0 || time >= MAX_SCHEDULE_MINUTES) return false;
+    }
+
+    IdRange current = trolleyDepartures.get(id);
+    ids.assign(current.begin(), current.end());
+    ids.insert(ids.end(), times.begin(), times.end());
+    sort(ids.begin(), ids.end());
+    ids.erase(unique(ids.begin(), ids.end()), ids.end());
+    trolleyDepartures.assign(id, ids);
+    return true;
+}
+
+bool TrolleySystem::addDepartures(string_view trolley, int first, int last, int headway) {
+    statPhase(Phase::APPLY);
+    if (headway <= 0 || first > last) return false;
+    vector<int> times;
+    for (long long time = first; time <= last; time += headway) {
+        times.push_back(static_cast<int>(time));
+    }
+    return addDepartures(trolley, times);
+}
+
+void TrolleySystem::nextDepartures(string_view stop, int time) const {
+    statPhase(Phase::VALIDATE);
+    int id = stopNames.find(stop);
+    if (id < 0 || stopTrolleys.size(id) == 0) {
+        out << "Stop " << stop << " is absent" << '\n';
+        return;
+    }
+
+    // Для каждого маршрута ближайший рейс ищется двоичным поиском по отправлениям
+    statPhase(Phase::APPLY);
+    vector<pair<int, int>> next;
+    for (int trolley : stopTrolleys.get(id)) {
+        IdRange offsets = trolleyOffsets.get(trolley);
+        IdRange departures = trolleyDepartures.get(trolley);
+        if (offsets.empty() || departures.empty()) continue;
+
+        IdRange route = trolleyStops.get(trolley);
+        int best = -1;
+        for (size_t p = 0; p < route.size(); ++p) {
+            if (route.first[p] != id) continue;
+            const int* it = lower_bound(departures.begin(), departures.end(), time - offsets.first[p]);
+            if (it != departures.end() && (best < 0 || *it + offsets.first[p] < best)) {
+                best = *it + offsets.first[p];
+            }
         }
-        cout << endl;
+        if (best >= 0) next.push_back({best, trolley});
+    }
+    sort(next.begin(), next.end());
+
+    statPhase(Phase::PRINT);
+    out << "Stop " << stop << " after ";
+    printTime(time);
+    out << ":";
+    if (next.empty()) out << " 0";
+    for (size_t i = 0; i < next.size(); ++i) {
+        out << (i == 0 ? " " : ", ") << "TRL " << trolleyNames.name(next[i].second) << " ";
+        printTime(next[i].first);
     }
+    out << '\n';
 }
 
-bool TrolleySystem::isTrolleyExist(const string& name) const {
-    return trolleys.find(name) != trolleys.end();
+bool TrolleySystem::findArrival(string_view from, string_view to, int time, Arrival& result) const {
+    result = Arrival();
+    int source = stopNames.find(from);
+    int target = stopNames.find(to);
+    if (source < 0 || target < 0) return false;
+    if (source == target) {
+        result.found = true;
+        result.arrival = time;
+        return true;
+    }
+
+    buildJourneyGraph();
+    size_t stops = stopNames.size();
+    if (earliest.size() < stops) {
+        earliest.resize(stops, INT32_MAX);
+        boardStop.resize(stops);
+        boardTime.resize(stops);
+        arrivedWith.resize(stops);
+        stopMark.resize(stops, 0);
+    }
+    routeMark.resize(trolleyNames.size(), 0);
+    routeFrom.resize(trolleyNames.size());
+
+    vector<int> touched{source};
+    vector<int> marked{source};
+    vector<int> routes;
+    earliest[source] = time;
+
+    while (!marked.empty()) {
+        // Маршруты, на которые можно сесть на улучшенных остановках, и самая ранняя такая позиция
+        ++markStamp;
+        routes.clear();
+        for (int stop : marked) {
+            for (int i = stopPositionOffsets[stop]; i < stopPositionOffsets[stop + 1]; ++i) {
+                int position = stopPositions[i];
+                int trolley = positionTrolley[position];
+                if (trolleyDepartures.size(trolley) == 0 || trolleyOffsets.size(trolley) == 0) continue;
+                int local = position - routeStart[trolley];
+                if (routeMark[trolley] != markStamp) {
+                    routeMark[trolley] = markStamp;
+                    routeFrom[trolley] = local;
+                    routes.push_back(trolley);
+                } else {
+                    routeFrom[trolley] = min(routeFrom[trolley], local);
+                }
+            }
+        }
+        marked.clear();
+
+        for (int trolley : routes) {
+            IdRange route = trolleyStops.get(trolley);
+            IdRange offsets = trolleyOffsets.get(trolley);
+            IdRange departures = trolleyDepartures.get(trolley);
+            int trip = -1;
+            int boardedAt = -1;
+            int boardedTime = 0;
+            for (int p = routeFrom[trolley]; p < static_cast<int>(route.size()); ++p) {
+                int stop = route.first[p];
+                if (trip >= 0) {
+                    int arrival = trip + offsets.first[p];
+                    if (arrival < earliest[stop] && arrival < earliest[target]) {
+                        if (earliest[stop] == INT32_MAX) touched.push_back(stop);
+                        earliest[stop] = arrival;
+                        boardStop[stop] = boardedAt;
+                        boardTime[stop] = boardedTime;
+                        arrivedWith[stop] = trolley;
+                        if (stopMark[stop] != markStamp) {
+                            stopMark[stop] = markStamp;
+                            marked.push_back(stop);
+                        }
+                    }
+                }
+                // Пересадка на более ранний рейс того же маршрута, если он уже достижим
+                if (earliest[stop] == INT32_MAX) continue;
+                const int* next = lower_bound(departures.begin(), departures.end(), earliest[stop] - offsets.first[p]);
+                if (next != departures.end() && (trip < 0 || *next < trip)) {
+                    trip = *next;
+                    boardedAt = stop;
+                    boardedTime = *next + offsets.first[p];
+                }
+            }
+        }
+    }
+
+    // Время прибытия вдоль цепочки строго убывает, поэтому восстановление конечно
+    if (earliest[target] != INT32_MAX) {
+        result.found = true;
+        result.arrival = earliest[target];
+        for (int stop = target; stop != source; stop = boardStop[stop]) {
+            result.legs.push_back({arrivedWith[stop], boardStop[stop], boardTime[stop], stop, earliest[stop]});
+        }
+        reverse(result.legs.begin(), result.legs.end());
+    }
+
+    for (int stop : touched) {
+        earliest[stop] = INT32_MAX;
+    }
+    return true;
+}
+
+void TrolleySystem::arrive(string_view from, string_view to, int time) const {
+    statPhase(Phase::APPLY);
+    Arrival result;
+    bool known = findArrival(from, to, time, result);
+    statPhase(Phase::PRINT);
+    if (!known) {
+        out << "Stop " << (stopNames.find(from) < 0 ? from : to) << " is absent" << '\n';
+        return;
+    }
+    out << "Arrive " << from << " -> " << to << " after ";
+    printTime(time);
+    if (!result.found) {
+        out << ": no trips" << '\n';
+        return;
+    }
+    out << ": ";
+    printTime(result.arrival);
+    out << '\n';
+    for (const TimedLeg& leg : result.legs) {
+        out << "TRL " << trolleyNames.name(leg.trolley) << ": " << stopNames.name(leg.from) << " ";
+        printTime(leg.departure);
+        out << " -> " << stopNames.name(leg.to) << " ";
+        printTime(leg.arrival);
+        out << '\n';
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (address) munmap(const_cast<char*>(address), length);
+}
+
+bool MappedFile::open(const string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    bool ok = fstat(fd, &info) == 0 && info.st_size > 0;
+    if (ok) {
+        void* mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ok = mapping != MAP_FAILED;
+        if (ok) {
+            address = static_cast<const char*>(mapping);
+            length = static_cast<size_t>(info.st_size);
+        }
+    }
+    ::close(fd);
+    return ok;
+}
+
+// Формат снимка: заголовок с таблицей секций, затем сами массивы подряд,
+// каждый с выравниванием на 8 байт. Числа хранятся в порядке байт машины
+namespace {
+
+const char SNAPSHOT_MAGIC[8] = {'T', 'R', 'L', 'S', 'N', 'A', 'P', '1'};
+const uint32_t SNAPSHOT_SECTIONS = 16;
+
+struct SnapshotSection {
+    uint64_t offset;
+    uint64_t bytes;
+};
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t sections;
+    int32_t activeStops;
+    SnapshotSection section[SNAPSHOT_SECTIONS];
+};
+
+uint64_t alignSection(uint64_t offset) {
+    return (offset + 7) & ~uint64_t(7);
+}
+
+}
+
+// Порядок секций задаётся только здесь и одинаков для записи и чтения
+template <typename Self, typename Visitor>
+void TrolleySystem::visitArrays(Self& self, Visitor& visit) {
+    NameTable::visitArrays(self.trolleyNames, visit);
+    NameTable::visitArrays(self.stopNames, visit);
+    AdjacencyLists::visitArrays(self.trolleyStops, visit);
+    AdjacencyLists::visitArrays(self.stopTrolleys, visit);
+    AdjacencyLists::visitArrays(self.trolleyOffsets, visit);
+    AdjacencyLists::visitArrays(self.trolleyDepartures, visit);
+    visit(self.trolleyOrder);
+    visit(self.trolleyAlive);
 }
 
-bool TrolleySystem::isStopExist(const string& name) const {
-    return stops.find(name) != stops.end();
+bool TrolleySystem::save(const string& path) const {
+    SnapshotHeader header{};
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.sections = SNAPSHOT_SECTIONS;
+    header.activeStops = activeStops;
+
+    uint32_t index = 0;
+    uint64_t offset = sizeof(header);
+    auto layout = [&](const auto& array) {
+        offset = alignSection(offset);
+        header.section[index++] = {offset, array.size() * sizeof(array[0])};
+        offset += array.size() * sizeof(array[0]);
+    };
+    visitArrays(*this, layout);
+
+    // Запись во временный файл и переименование: старый снимок может быть
+    // отображён в память этим же процессом и не должен меняться под ним
+    string temporary = path + ".tmp";
+    ofstream file(temporary, ios::binary | ios::trunc);
+    if (!file) return false;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    index = 0;
+    const char padding[8] = {};
+    auto write = [&](const auto& array) {
+        uint64_t position = sizeof(header);
+        if (index > 0) position = header.section[index - 1].offset + header.section[index - 1].bytes;
+        file.write(padding, static_cast<streamsize>(header.section[index].offset - position));
+        file.write(reinterpret_cast<const char*>(array.data()), static_cast<streamsize>(header.section[index].bytes));
+        ++index;
+    };
+    visitArrays(*this, write);
+    file.close();
+    if (!file || rename(temporary.c_str(), path.c_str()) != 0) {
+        remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Проверка связей загруженного снимка за один проход по всем спискам: порядок
+// маршрутов, расписания и число используемых остановок. Границы id проверены раньше
+bool TrolleySystem::validateContents(int storedActiveStops) const {
+    int trolleys = trolleyNames.size();
+    int alive = 0;
+    for (int trolley = 0; trolley < trolleys; ++trolley) {
+        if (trolleyAlive[trolley] != 0 && trolleyAlive[trolley] != 1) return false;
+        alive += trolleyAlive[trolley];
+
+        // Смещения - от нуля и строго растут по остановкам маршрута, отправления строго растут
+        IdRange offsets = trolleyOffsets.get(trolley);
+        if (!offsets.empty() && (offsets.size() != trolleyStops.get(trolley).size() || offsets.first[0] != 0)) return false;
+        for (size_t i = 1; i < offsets.size(); ++i) {
+            if (offsets.first[i] <= offsets.first[i - 1]) return false;
+        }
+        IdRange departures = trolleyDepartures.get(trolley);
+        for (size_t i = 1; i < departures.size(); ++i) {
+            if (departures.first[i] <= departures.first[i - 1]) return false;
+        }
+    }
+
+    // trolleyOrder - все существующие маршруты, каждый один раз, по возрастанию имён
+    if (trolleyOrder.size() != static_cast<size_t>(alive)) return false;
+    for (size_t i = 0; i < trolleyOrder.size(); ++i) {
+        int trolley = trolleyOrder[i];
+        if (trolley < 0 || trolley >= trolleys || !trolleyAlive[trolley]) return false;
+        if (i > 0 && trolleyNames.name(trolleyOrder[i - 1]) >= trolleyNames.name(trolley)) return false;
+    }
+
+    int active = 0;
+    for (int stop = 0; stop < stopNames.size(); ++stop) {
+        if (stopTrolleys.size(stop) > 0) ++active;
+    }
+    return active == storedActiveStops;
 }
 
-CommandType parseCommand(const string& cmd) {
-    if (cmd == "CREATE_TRL") return CommandType::CREATE_TRL;
-    if (cmd == "TRL_IN_STOP") return CommandType::TRL_IN_STOP;
-    if (cmd == "STOPS_IN_TRL") return CommandType::STOPS_IN_TRL;
-    if (cmd == "TRLS") return CommandType::TRLS;
+// Загрузка не разбирает элементы: массивы сети просто начинают смотреть в
+// отображённый файл. Перед подменой состояния один проход проверяет границы
+// секций и блоков, смещения имён и каждый id в списках
+bool TrolleySystem::load(const string& path) {
+    auto file = make_unique<MappedFile>();
+    if (!file->open(path) || file->size() < sizeof(SnapshotHeader)) return false;
+
+    SnapshotHeader header;
+    memcpy(&header, file->data(), sizeof(header));
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) return false;
+    if (header.sections != SNAPSHOT_SECTIONS) return false;
+
+    TrolleySystem loaded;
+    uint32_t index = 0;
+    bool ok = true;
+    auto map = [&](auto& array) {
+        using Element = remove_const_t<remove_reference_t<decltype(array[0])>>;
+        const SnapshotSection& section = header.section[index++];
+        if (section.offset % alignof(Element) != 0 || section.bytes % sizeof(Element) != 0
+            || section.offset > file->size() || section.bytes > file->size() - section.offset) {
+            ok = false;
+            return;
+        }
+        array.map(reinterpret_cast<const Element*>(file->data() + section.offset), section.bytes / sizeof(Element));
+    };
+    visitArrays(loaded, map);
+
+    int trolleys = ok ? loaded.trolleyNames.size() : 0;
+    int stops = ok ? loaded.stopNames.size() : 0;
+    ok = ok && loaded.trolleyNames.valid() && loaded.stopNames.valid()
+        && loaded.trolleyStops.validate(trolleys, stops) && loaded.stopTrolleys.validate(stops, trolleys)
+        && loaded.trolleyOffsets.validate(trolleys, MAX_SCHEDULE_MINUTES)
+        && loaded.trolleyDepartures.validate(trolleys, MAX_SCHEDULE_MINUTES)
+        && loaded.trolleyAlive.size() == static_cast<size_t>(trolleys)
+        && loaded.validateContents(header.activeStops);
+    if (!ok) return false;
+
+    loaded.activeStops = header.activeStops;
+    loaded.snapshot = move(file);
+    *this = move(loaded);
+    return true;
+}
+
+int TrolleySystem::trolleyCount() const {
+    return static_cast<int>(trolleyOrder.size());
+}
+
+int TrolleySystem::stopCount() const {
+    return activeStops;
+}
+
+CommandType parseCommand(string_view cmd) {
+    switch (commandHash(cmd)) {
+        case commandHash("CREATE_TRL"): if (cmd == "CREATE_TRL") return CommandType::CREATE_TRL; break;
+        case commandHash("TRL_IN_STOP"): if (cmd == "TRL_IN_STOP") return CommandType::TRL_IN_STOP; break;
+        case commandHash("STOPS_IN_TRL"): if (cmd == "STOPS_IN_TRL") return CommandType::STOPS_IN_TRL; break;
+        case commandHash("TRLS"): if (cmd == "TRLS") return CommandType::TRLS; break;
+        case commandHash("UPDATE_TRL"): if (cmd == "UPDATE_TRL") return CommandType::UPDATE_TRL; break;
+        case commandHash("DELETE_TRL"): if (cmd == "DELETE_TRL") return CommandType::DELETE_TRL; break;
+        case commandHash("ROUTE"): if (cmd == "ROUTE") return CommandType::ROUTE; break;
+        case commandHash("SCHEDULE"): if (cmd == "SCHEDULE") return CommandType::SCHEDULE; break;
+        case commandHash("DEPART"): if (cmd == "DEPART") return CommandType::DEPART; break;
+        case commandHash("NEXT"): if (cmd == "NEXT") return CommandType::NEXT; break;
+        case commandHash("ARRIVE"): if (cmd == "ARRIVE") return CommandType::ARRIVE; break;
+        case commandHash("SAVE"): if (cmd == "SAVE") return CommandType::SAVE; break;
+        case commandHash("LOAD"): if (cmd == "LOAD") return CommandType::LOAD; break;
+        case commandHash("STATS"): if (cmd == "STATS") return CommandType::STATS; break;
+    }
     throw invalid_argument("Unknown command");
 }
\ No newline at end of file
@@ -1,29 +1,298 @@
+#ifndef TROLLEY_H
 #define TROLLEY_H
 
 #include <vector>
 #include <string>
-#include <map>
+#include <string_view>
+#include <cstdint>
+#include <memory>
+#include <initializer_list>
 using namespace std;
 
 enum class CommandType {
     CREATE_TRL,
     TRL_IN_STOP,
     STOPS_IN_TRL,
-    TRLS
+    TRLS,
+    UPDATE_TRL,
+    DELETE_TRL,
+    ROUTE,
+    SCHEDULE,
+    DEPART,
+    NEXT,
+    ARRIVE,
+    SAVE,
+    LOAD,
+    STATS
+};
+
+// Диапазон id внутри плоского массива
+struct IdRange {
+    const int* first;
+    const int* last;
+
+    const int* begin() const { return first; }
+    const int* end() const { return last; }
+    size_t size() const { return static_cast<size_t>(last - first); }
+    bool empty() const { return first == last; }
+};
+
+// Плоский массив, который либо владеет данными, либо смотрит прямо в отображённый
+// в память снимок. Чтение одинаково в обоих случаях, первое изменение копирует
+// данные снимка в собственный vector
+template <typename T>
+class FlatArray {
+private:
+    vector<T> owned;
+    const T* mapped = nullptr;
+    size_t mappedSize = 0;
+
+public:
+    FlatArray() = default;
+    FlatArray(initializer_list<T> values) : owned(values) {}
+
+    const T* data() const { return mapped ? mapped : owned.data(); }
+    size_t size() const { return mapped ? mappedSize : owned.size(); }
+    bool empty() const { return size() == 0; }
+    const T* begin() const { return data(); }
+    const T* end() const { return data() + size(); }
+    const T& operator[](size_t i) const { return data()[i]; }
+
+    vector<T>& mutate() {
+        if (mapped) {
+            owned.assign(mapped, mapped + mappedSize);
+            mapped = nullptr;
+            mappedSize = 0;
+        }
+        return owned;
+    }
+
+    void map(const T* values, size_t count) {
+        vector<T>().swap(owned);
+        mapped = values;
+        mappedSize = count;
+    }
+};
+
+// Файл снимка, отображённый в память только для чтения
+class MappedFile {
+private:
+    const char* address = nullptr;
+    size_t length = 0;
+
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    bool open(const string& path);
+    const char* data() const { return address; }
+    size_t size() const { return length; }
+};
+
+// Имена интернируются один раз в плотные id: символы всех имён лежат
+// в одном массиве, поиск идёт по хеш-таблице с открытой адресацией
+class NameTable {
+private:
+    FlatArray<char> chars;
+    FlatArray<uint32_t> offsets{0};
+    FlatArray<int> slots;
+
+    size_t slotFor(string_view name) const;
+    void grow();
+
+public:
+    int find(string_view name) const;
+    int intern(string_view name);
+    string_view name(int id) const;
+    int size() const;
+
+    // Массивы таблицы для снимка, всегда в одном порядке
+    template <typename Self, typename Visitor>
+    static void visitArrays(Self& self, Visitor& visit) {
+        visit(self.chars);
+        visit(self.offsets);
+        visit(self.slots);
+    }
+    bool valid() const;
+};
+
+// Списки смежности в одном плоском массиве: у каждого списка свой блок с запасом,
+// переполненный блок переезжает в конец массива, освободившееся место
+// собирается при сжатии
+class AdjacencyLists {
+private:
+    struct Block {
+        int offset;
+        int size;
+        int capacity;
+    };
+
+    FlatArray<int> data;
+    FlatArray<Block> blocks;
+    size_t garbage = 0;
+
+    void reserve(int list, int capacity);
+    void compact();
+
+public:
+    void resize(int lists);
+    void push(int list, int value);
+    void erase(int list, int value);
+    void assign(int list, const vector<int>& values);
+    IdRange get(int list) const;
+    int size(int list) const;
+
+    template <typename Self, typename Visitor>
+    static void visitArrays(Self& self, Visitor& visit) {
+        visit(self.data);
+        visit(self.blocks);
+    }
+    // Проверка блоков после загрузки снимка: границы блоков и значения в [0, limit).
+    // Заодно восстанавливает счётчик мусора
+    bool validate(int lists, int limit);
+};
+
+// Поездка между остановками: участки на отдельных маршрутах
+struct JourneyLeg {
+    int trolley;
+    int from;
+    int to;
+    int stops;
+};
+
+struct Journey {
+    bool found = false;
+    int transfers = 0;
+    int stops = 0;
+    vector<JourneyLeg> legs;
+};
+
+// Поездка по расписанию: участки с временем отправления и прибытия в минутах от полуночи
+struct TimedLeg {
+    int trolley;
+    int from;
+    int departure;
+    int to;
+    int arrival;
+};
+
+struct Arrival {
+    bool found = false;
+    int arrival = 0;
+    vector<TimedLeg> legs;
 };
 
 class TrolleySystem {
 private:
-    map<std::string, vector<std::string>> trolleys;
-    map<std::string, vector<std::string>> stops;
+    NameTable trolleyNames;
+    NameTable stopNames;
+    AdjacencyLists trolleyStops;   // маршрут -> остановки по порядку
+    AdjacencyLists stopTrolleys;   // остановка -> маршруты
+    FlatArray<int> trolleyOrder;   // id существующих маршрутов в порядке имён
+    FlatArray<char> trolleyAlive;  // удалённые маршруты остаются в таблице имён
+    int activeStops = 0;           // остановки, через которые проходит хотя бы один маршрут
+
+    // Метки для сравнения старого и нового списка остановок маршрута
+    vector<int> oldMark;
+    vector<int> newMark;
+    int stamp = 0;
+    vector<int> ids;
+
+    // Граф для поиска поездок: вершины - остановки и позиции на маршрутах.
+    // Строится заново после изменения сети, деревья кратчайших путей
+    // от последних источников кешируются
+    struct JourneyTree {
+        int source;
+        vector<uint64_t> cost;
+        vector<int> parent;
+    };
+
+    static constexpr size_t JOURNEY_CACHE_SIZE = 32;
+
+    int version = 0;
+    mutable int graphVersion = -1;
+    mutable vector<int> positionStop;
+    mutable vector<int> positionTrolley;
+    mutable vector<int> stopPositionOffsets;
+    mutable vector<int> stopPositions;
+    mutable vector<JourneyTree> journeyCache;
+    mutable size_t journeyCacheNext = 0;
+
+    void buildJourneyGraph() const;
+    const JourneyTree& journeyTree(int source) const;
+
+    // Расписание: для маршрута - время в пути от первой остановки до каждой
+    // позиции и отсортированные времена отправления с первой остановки
+    AdjacencyLists trolleyOffsets;
+    AdjacencyLists trolleyDepartures;
+
+    // Поиск по расписанию идёт раундами по маршрутам (RAPTOR): в раунде каждый
+    // маршрут, на который можно пересесть, просматривается один раз от самой ранней
+    // позиции посадки, ближайший рейс находится двоичным поиском по отправлениям.
+    // Метки остановок и маршрутов сбрасываются по номеру запроса, а не очисткой
+    mutable vector<int> routeStart;
+    mutable vector<int> earliest;
+    mutable vector<int> boardStop;
+    mutable vector<int> boardTime;
+    mutable vector<int> arrivedWith;
+    mutable vector<int> stopMark;
+    mutable vector<int> routeMark;
+    mutable vector<int> routeFrom;
+    mutable int markStamp = 0;
+
+    // Снимок, в который смотрят массивы сети после LOAD
+    unique_ptr<MappedFile> snapshot;
+
+    template <typename Self, typename Visitor>
+    static void visitArrays(Self& self, Visitor& visit);
+    bool validateContents(int storedActiveStops) const;
+
+    void addMembership(int stop, int trolley);
+    void removeMembership(int stop, int trolley);
+    void setStops(int trolley, const vector<int>& newStops);
 
 public:
-    void createTrolley(const string& name, const vector<std::string>& stopsList);
-    void trolleysForStop(const string& stop) const;
-    void stopsForTrolley(const string& trolley) const;
+    void createTrolley(string_view name, const vector<string_view>& stopsList);
+    bool updateTrolley(string_view name, const vector<string_view>& stopsList);
+    bool deleteTrolley(string_view name);
+    void trolleysForStop(string_view stop) const;
+    void stopsForTrolley(string_view trolley) const;
     void allTrolleys() const;
-    bool isTrolleyExist(const string& name) const;
-    bool isStopExist(const string& name) const;
+    bool isTrolleyExist(string_view name) const;
+    bool isStopExist(string_view name) const;
+
+    // Поездка с минимумом пересадок, а при равенстве - с минимумом перегонов.
+    // Маршруты считаются двусторонними
+    bool findJourney(string_view from, string_view to, Journey& journey) const;
+    void route(string_view from, string_view to) const;
+
+    // Время в пути по перегонам маршрута; число перегонов - остановки минус один
+    bool setSegmentTimes(string_view trolley, const vector<int>& minutes);
+    // Отправления с первой остановки: явный список или каждые headway минут с first до last
+    bool addDepartures(string_view trolley, const vector<int>& times);
+    bool addDepartures(string_view trolley, int first, int last, int headway);
+    void nextDepartures(string_view stop, int time) const;
+    bool findArrival(string_view from, string_view to, int time, Arrival& result) const;
+    void arrive(string_view from, string_view to, int time) const;
+
+    // Снимок сети - плоский двоичный файл с таблицами имён, списками смежности и
+    // расписанием. Загруженный снимок отображается в память и используется на месте
+    bool save(const string& path) const;
+    bool load(const string& path);
+    int trolleyCount() const;
+    int stopCount() const;
 };
 
-CommandType parseCommand(const string& cmd);
\ No newline at end of file
+// Верхняя граница времени в пути от первой остановки и времён отправления, минуты:
+// SCHEDULE и DEPART не принимают больше, LOAD отвергает снимок с большими значениями.
+// Сумма отправления и времени в пути не переполняет int
+constexpr int MAX_SCHEDULE_MINUTES = 1 << 24;
+
+// Время вида ЧЧ:ММ в минутах от полуночи (допускается до 47:59 для рейсов после полуночи)
+bool parseTime(string_view text, int& minutes);
+
+CommandType parseCommand(string_view cmd);
+
+#endif
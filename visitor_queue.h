@@ -0,0 +1,56 @@
+#ifndef VISITOR_QUEUE_H
+#define VISITOR_QUEUE_H
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+using namespace std;
+
+// Распределение очереди посетителей по окнам: общая часть электронной очереди
+// (Task2) и проверки моделирования (bench/queue_simulation)
+struct Visitor {
+    string ticket;
+    int duration;
+};
+
+struct Window {
+    int total_time = 0;
+    vector<Visitor> visitors;
+};
+
+// Окна лежат в min-куче по (total_time, номер окна): вершина - наименее загруженное
+// окно, а при равной загрузке - окно с меньшим номером, как при линейном поиске
+inline vector<Window> distribute_queue(queue<Visitor>& q, int windows_count) {
+    vector<Window> windows(windows_count);
+
+    priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> load;
+    for (int i = 0; i < windows_count; ++i) {
+        load.push({0, i});
+    }
+
+    while (!q.empty()) {
+        int index = load.top().second;
+        load.pop();
+
+        Window& window = windows[index];
+        window.total_time += q.front().duration;
+        window.visitors.push_back(move(q.front()));
+        q.pop();
+
+        load.push({window.total_time, index});
+    }
+    return windows;
+}
+
+inline int makespan(const vector<Window>& windows) {
+    int result = 0;
+    for (const Window& window : windows) {
+        result = max(result, window.total_time);
+    }
+    return result;
+}
+
+#endif
@@ -0,0 +1,264 @@
+#ifndef WAL_H
+#define WAL_H
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "output.h"
+
+// CRC-32 (IEEE) с таблицей, построенной при компиляции
+inline uint32_t crc32(const char* data, size_t size) {
+    static constexpr auto table = [] {
+        std::array<uint32_t, 256> values{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            values[i] = c;
+        }
+        return values;
+    }();
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+// Когда журнал сбрасывается на диск:
+//   ALWAYS - fsync после каждой операции;
+//   GROUP  - групповая фиксация: операции копятся и пишутся одним fsync, когда
+//            набралось GROUP_BYTES, программа ждёт ввода или сбрасывает ответ
+//            (sync) либо с первой незаписанной операции прошло GROUP_DELAY - за
+//            этим сроком следит фоновый поток журнала;
+//   OFF    - каждый кадр сразу пишется в файл, но без fsync: данные переживают
+//            падение процесса, но не системы
+enum class SyncPolicy {
+    ALWAYS,
+    GROUP,
+    OFF
+};
+
+inline bool parseSyncPolicy(std::string_view text, SyncPolicy& policy) {
+    if (text == "always") policy = SyncPolicy::ALWAYS;
+    else if (text == "group") policy = SyncPolicy::GROUP;
+    else if (text == "off") policy = SyncPolicy::OFF;
+    else return false;
+    return true;
+}
+
+// Атомарная замена файла: запись во временный файл, fsync, rename и fsync каталога
+inline bool writeFileDurably(const std::string& dir, const std::string& name, const std::string& data) {
+    std::string path = dir + "/" + name;
+    std::string temporary = path + ".tmp";
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    bool ok = writeAll(fd, data.data(), data.size()) && ::fsync(fd) == 0;
+    ::close(fd);
+    if (!ok || ::rename(temporary.c_str(), path.c_str()) != 0) {
+        ::unlink(temporary.c_str());
+        return false;
+    }
+    int dir_fd = ::open(dir.c_str(), O_RDONLY);
+    if (dir_fd >= 0) {
+        ::fsync(dir_fd);
+        ::close(dir_fd);
+    }
+    return true;
+}
+
+// Журнал упреждающей записи: файл из кадров [длина][crc32][данные].
+// Кадр - атомарная единица: при восстановлении недописанный или испорченный
+// хвост отбрасывается целиком. Содержимое кадров определяет владелец журнала
+class WriteAheadLog {
+private:
+    static constexpr size_t HEADER_SIZE = 8;
+    static constexpr size_t GROUP_BYTES = 1 << 16;
+    static constexpr std::chrono::milliseconds GROUP_DELAY{5};
+
+    int fd = -1;
+    SyncPolicy policy = SyncPolicy::GROUP;
+    std::string frame;    // открытый кадр текущей операции
+    std::string pending;  // закрытые кадры, ещё не записанные в файл
+    std::chrono::steady_clock::time_point first_pending;
+    uint64_t size = 0;    // размер журнала вместе с pending
+    bool failed = false;  // запись или fsync не удались: журнал больше не пишется
+
+    // pending, first_pending и fd делятся с фоновым потоком групповой фиксации
+    std::mutex lock;
+    std::condition_variable wake;
+    std::thread flusher;
+    bool stopping = false;
+
+    // При ошибке файл обрезается до последнего целого кадра, а pending сохраняется:
+    // недописанный кадр не остаётся в середине журнала, и операции не считаются записанными
+    bool syncLocked() {
+        if (failed) return false;
+        if (fd < 0 || pending.empty()) return true;
+        bool ok = writeAll(fd, pending.data(), pending.size());
+        if (ok && policy != SyncPolicy::OFF) ok = ::fdatasync(fd) == 0;
+        if (!ok) {
+            off_t written = static_cast<off_t>(size - pending.size());
+            if (::ftruncate(fd, written) == 0) ::lseek(fd, written, SEEK_SET);
+            failed = true;
+            return false;
+        }
+        pending.clear();
+        return true;
+    }
+
+    void seal(const char* data, size_t length) {
+        std::lock_guard<std::mutex> guard(lock);
+        bool first = pending.empty();
+        if (first) first_pending = std::chrono::steady_clock::now();
+        uint32_t header[2] = {static_cast<uint32_t>(length), crc32(data, length)};
+        pending.append(reinterpret_cast<const char*>(header), HEADER_SIZE);
+        pending.append(data, length);
+        size += HEADER_SIZE + length;
+
+        if (policy != SyncPolicy::GROUP || pending.size() >= GROUP_BYTES) {
+            syncLocked();
+        } else if (first) {
+            // Фоновый поток отсчитывает GROUP_DELAY от первой незаписанной операции
+            wake.notify_one();
+        }
+    }
+
+    // Фоновый поток GROUP: записывает кадры, пролежавшие в pending GROUP_DELAY
+    void flushLoop() {
+        std::unique_lock<std::mutex> guard(lock);
+        while (!stopping) {
+            if (pending.empty() || failed) {
+                wake.wait(guard);
+                continue;
+            }
+            std::chrono::steady_clock::time_point deadline = first_pending + GROUP_DELAY;
+            if (std::chrono::steady_clock::now() >= deadline) {
+                syncLocked();
+            } else {
+                wake.wait_until(guard, deadline);
+            }
+        }
+    }
+
+public:
+    WriteAheadLog() = default;
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    ~WriteAheadLog() {
+        close();
+    }
+
+    // Читает целые кадры с начала файла и передаёт их данные в replay, пока replay
+    // возвращает true. Хвост после последнего целого кадра обрезается, и журнал
+    // открывается на дозапись. Возвращает false, если файл не удалось открыть
+    template <typename Replay>
+    bool open(const std::string& path, SyncPolicy sync_policy, Replay replay) {
+        close();
+        policy = sync_policy;
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd < 0) return false;
+
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            close();
+            return false;
+        }
+        std::string data(static_cast<size_t>(info.st_size), '\0');
+        size_t loaded = 0;
+        while (loaded < data.size()) {
+            ssize_t got = ::pread(fd, &data[loaded], data.size() - loaded, static_cast<off_t>(loaded));
+            if (got <= 0) break;
+            loaded += static_cast<size_t>(got);
+        }
+
+        size_t valid = 0;
+        while (valid + HEADER_SIZE <= loaded) {
+            uint32_t header[2];
+            std::memcpy(header, data.data() + valid, HEADER_SIZE);
+            if (header[0] > loaded - valid - HEADER_SIZE) break;
+            const char* payload = data.data() + valid + HEADER_SIZE;
+            if (crc32(payload, header[0]) != header[1]) break;
+            if (!replay(std::string_view(payload, header[0]))) break;
+            valid += HEADER_SIZE + header[0];
+        }
+        if (valid != static_cast<size_t>(info.st_size)) {
+            if (::ftruncate(fd, static_cast<off_t>(valid)) != 0) {
+                close();
+                return false;
+            }
+            ::fsync(fd);
+        }
+        ::lseek(fd, static_cast<off_t>(valid), SEEK_SET);
+        size = valid;
+        failed = false;
+        if (policy == SyncPolicy::GROUP) {
+            stopping = false;
+            flusher = std::thread([this] { flushLoop(); });
+        }
+        return true;
+    }
+
+    bool isOpen() const {
+        return fd >= 0;
+    }
+
+    // Данные открытого кадра; кадр закрывает commit, отбрасывает discard
+    void append(const void* data, size_t length) {
+        frame.append(static_cast<const char*>(data), length);
+    }
+
+    void commit() {
+        if (frame.empty()) return;
+        seal(frame.data(), frame.size());
+        frame.clear();
+    }
+
+    void discard() {
+        frame.clear();
+    }
+
+    // Отдельный кадр в обход открытого: для записей, которые не отменяются вместе с операцией
+    void commitRecord(const void* data, size_t length) {
+        seal(static_cast<const char*>(data), length);
+    }
+
+    // Запись накопленных кадров и fsync по политике; false, если журнал не записан
+    // (сейчас или раньше) и подтверждать операции нельзя
+    bool sync() {
+        std::lock_guard<std::mutex> guard(lock);
+        return syncLocked();
+    }
+
+    uint64_t bytes() const {
+        return size;
+    }
+
+    void close() {
+        if (flusher.joinable()) {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                stopping = true;
+            }
+            wake.notify_one();
+            flusher.join();
+        }
+        if (fd < 0) return;
+        sync();
+        ::close(fd);
+        fd = -1;
+        pending.clear();
+        frame.clear();
+    }
+};
+
+#endif
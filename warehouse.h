@@ -0,0 +1,1097 @@
+#ifndef WAREHOUSE_H
+#define WAREHOUSE_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <memory>
+#include <mutex>
+#include "cell_scan.h"
+#include "output.h"
+#include "journal.h"
+#include "wal.h"
+#include "stats.h"
+using namespace std;
+
+// Битовая карта слотов с двухуровневым поиском следующего установленного бита:
+// summary отмечает непустые слова, поэтому поиск не обходит занятые участки
+class SlotBitmap {
+private:
+    int size;
+    vector<uint64_t> words;
+    vector<uint64_t> summary;
+
+public:
+    SlotBitmap(int n, bool value)
+        : size(n), words((n + 63) / 64, 0), summary((words.size() + 63) / 64, 0) {
+        if (value) {
+            for (int i = 0; i < n; ++i) set(i);
+        }
+    }
+
+    bool test(int i) const {
+        return (words[i >> 6] >> (i & 63)) & 1;
+    }
+
+    void set(int i) {
+        int w = i >> 6;
+        words[w] |= uint64_t(1) << (i & 63);
+        summary[w >> 6] |= uint64_t(1) << (w & 63);
+    }
+
+    void reset(int i) {
+        int w = i >> 6;
+        words[w] &= ~(uint64_t(1) << (i & 63));
+        if (words[w] == 0) {
+            summary[w >> 6] &= ~(uint64_t(1) << (w & 63));
+        }
+    }
+
+    // Первый установленный бит с номером >= from или -1
+    int findNext(int from) const {
+        if (from >= size) return -1;
+        int w = from >> 6;
+        uint64_t bits = words[w] & (~uint64_t(0) << (from & 63));
+        if (bits) return (w << 6) + __builtin_ctzll(bits);
+
+        ++w;
+        int s = w >> 6;
+        if (s >= static_cast<int>(summary.size())) return -1;
+        uint64_t mask = (w & 63) ? summary[s] & (~uint64_t(0) << (w & 63)) : summary[s];
+        while (!mask) {
+            if (++s >= static_cast<int>(summary.size())) return -1;
+            mask = summary[s];
+        }
+        w = (s << 6) + __builtin_ctzll(mask);
+        return (w << 6) + __builtin_ctzll(words[w]);
+    }
+};
+
+// Записи в журнале на диске: товар получает id при первом появлении,
+// изменение ячейки хранится как (слот, товар, дельта)
+enum class LogRecord : uint8_t {
+    PRODUCT = 1,
+    CHANGE = 2
+};
+
+// Геометрия склада: зоны, стеллажи в зоне, секции в стеллаже, полки в секции и
+// вместимость. RuntimeGeometry задаётся при запуске, FixedGeometry - при компиляции:
+// у неё все размеры, шаги и вместимости constexpr, поэтому разбор адреса и расчёты
+// по зонам сворачиваются в арифметику с константами
+class RuntimeGeometry {
+private:
+    int zones;
+    int first_zone;  // буква первой зоны склада: у шарда многозонного склада это не A
+    int shelves;
+    int sections;
+    int levels;
+    int total_capacity;
+    int cells_per_zone;
+
+public:
+    static constexpr int CELL_CAPACITY = 10;
+
+    RuntimeGeometry(int z, int spz, int sec, int spl, int cap, int first = 0)
+        : zones(z), first_zone(first), shelves(spz), sections(sec), levels(spl), total_capacity(cap),
+          cells_per_zone(spz * sec * spl) {}
+
+    int Zones() const { return zones; }
+    int FirstZone() const { return first_zone; }
+    int Shelves() const { return shelves; }
+    int Sections() const { return sections; }
+    int Levels() const { return levels; }
+    int CellsPerZone() const { return cells_per_zone; }
+    int CellCount() const { return zones * cells_per_zone; }
+    int TotalCapacity() const { return total_capacity; }
+};
+
+template <int Z, int S, int Sec, int L, int CellCap>
+class FixedGeometry {
+public:
+    static_assert(Z >= 1 && Z <= 26 && S >= 1 && S <= 99 && Sec >= 1 && Sec <= 9 && L >= 1 && L <= 9,
+                  "Адрес вида A0101 вмещает до 26 зон, 99 стеллажей, 9 секций и 9 полок");
+    static_assert(CellCap >= 1, "Вместимость ячейки должна быть положительной");
+
+    static constexpr int CELL_CAPACITY = CellCap;
+
+    static constexpr int Zones() { return Z; }
+    static constexpr int FirstZone() { return 0; }
+    static constexpr int Shelves() { return S; }
+    static constexpr int Sections() { return Sec; }
+    static constexpr int Levels() { return L; }
+    static constexpr int CellsPerZone() { return S * Sec * L; }
+    static constexpr int CellCount() { return Z * CellsPerZone(); }
+    static constexpr int TotalCapacity() { return CellCount() * CellCap; }
+};
+
+// Номер слота для адреса вида A0101 или -1, если адрес неверный. Все проверки
+// собираются в одно условие без ранних выходов, слот считается по шагам геометрии
+template <typename Geometry>
+int DecodeSlot(const Geometry& geometry, string_view address) {
+    if (address.length() != 5) return -1;
+    auto at = [&](int i) { return static_cast<unsigned>(static_cast<unsigned char>(address[i])); };
+
+    unsigned zone = at(0) - 'A' - static_cast<unsigned>(geometry.FirstZone());
+    unsigned tens = at(1) - '0';
+    unsigned ones = at(2) - '0';
+    unsigned section = at(3) - '0';
+    unsigned level = at(4) - '0';
+    unsigned shelf = tens * 10 + ones;
+
+    bool valid = (zone < static_cast<unsigned>(geometry.Zones())) & (tens <= 9) & (ones <= 9)
+                 & (section <= 9) & (level <= 9)
+                 & (shelf - 1 < static_cast<unsigned>(geometry.Shelves()))
+                 & (section - 1 < static_cast<unsigned>(geometry.Sections()))
+                 & (level - 1 < static_cast<unsigned>(geometry.Levels()));
+    unsigned slot = ((zone * static_cast<unsigned>(geometry.Shelves()) + shelf - 1)
+                     * static_cast<unsigned>(geometry.Sections()) + section - 1)
+                    * static_cast<unsigned>(geometry.Levels()) + level - 1;
+    return valid ? static_cast<int>(slot) : -1;
+}
+
+template <typename Geometry>
+class BasicWarehouse {
+private:
+    static constexpr int CELL_CAPACITY = Geometry::CELL_CAPACITY;
+    static constexpr int NO_PRODUCT = -1;
+
+    Geometry geometry;
+    int used_capacity = 0;
+    int empty_cells;
+
+    // Ячейки хранятся плотно: адрес один раз переводится в номер слота,
+    // а количество и товар лежат в массивах, индексируемых этим номером
+    vector<int> quantities;
+    vector<int> products;
+
+    // Названия товаров интернируются в небольшие целые id
+    unordered_map<string, int> product_ids;
+    vector<string> product_names;
+
+    // Вторичный индекс: ячейки каждого товара и его общий остаток.
+    // slot_position хранит позицию слота в списке его товара для удаления за O(1)
+    vector<vector<int>> product_slots;
+    vector<int> product_totals;
+    vector<int> slot_position;
+
+    // Неполные ячейки каждого товара для автоматического размещения и отбора,
+    // partial_position - позиция слота в этом списке (или -1)
+    vector<vector<int>> product_partial;
+    vector<int> partial_position;
+
+    // Счётчики по зонам обновляются в ADD/REMOVE, чтобы INFO не обходил ячейки
+    vector<int> zone_used;
+    vector<int> zone_occupied;
+
+    // Свободные ячейки для автоматического размещения
+    SlotBitmap free_slots;
+
+    // Изменение количества в ячейке. Все изменения попадают в журнал отмены:
+    // пакет - одна операция журнала, отдельные ADD/REMOVE - по одной операции
+    struct Change {
+        int slot;
+        int product;
+        int delta;
+    };
+
+    static constexpr size_t JOURNAL_RECORDS = 1 << 16;
+
+    bool in_batch = false;
+    Journal<Change> journal{JOURNAL_RECORDS};
+
+    // Журнал на диске, если склад хранится в каталоге данных. Операция попадает
+    // в него одним кадром в момент завершения, откаченный пакет не попадает вовсе
+    WriteAheadLog* wal = nullptr;
+
+    string error;
+    vector<pair<int, int>> moves;
+
+    // Битовая карта ячеек последнего диапазона (EMPTY, CLEAR)
+    mutable vector<uint64_t> range_bits;
+
+    bool Fail(string message) {
+        error = move(message);
+        return false;
+    }
+
+    void PrintMoves(char sign, Output& sink) const {
+        for (size_t i = 0; i < moves.size(); ++i) {
+            if (i != 0) sink << ",";
+            sink << " " << AddressOf(moves[i].first) << " (" << sign << moves[i].second << ")";
+        }
+        sink << '\n';
+    }
+
+    int InternProduct(const string& product) {
+        auto it = product_ids.find(product);
+        if (it != product_ids.end()) return it->second;
+        int id = static_cast<int>(product_names.size());
+        product_names.push_back(product);
+        product_ids.emplace(product, id);
+        product_slots.emplace_back();
+        product_totals.push_back(0);
+        product_partial.emplace_back();
+        if (wal) {
+            // Товар пишется отдельным кадром: id остаётся за ним, даже если операция откатится
+            string record(1 + 2 * sizeof(int32_t) + product.size(), '\0');
+            record[0] = static_cast<char>(LogRecord::PRODUCT);
+            int32_t header[2] = {id, static_cast<int32_t>(product.size())};
+            memcpy(&record[1], header, sizeof(header));
+            memcpy(&record[1 + sizeof(header)], product.data(), product.size());
+            wal->commitRecord(record.data(), record.size());
+        }
+        return id;
+    }
+
+    void LogChange(int slot, int product, int delta) {
+        char record[1 + 3 * sizeof(int32_t)];
+        record[0] = static_cast<char>(LogRecord::CHANGE);
+        int32_t fields[3] = {slot, product, delta};
+        memcpy(record + 1, fields, sizeof(fields));
+        wal->append(record, sizeof(record));
+    }
+
+    void EndOperation() {
+        if (wal) wal->commit();
+    }
+
+    // Переносит слот в список неполных ячеек товара или убирает из него
+    // после изменения количества
+    void UpdatePartial(int slot, int product) {
+        bool partial = quantities[slot] > 0 && quantities[slot] < CELL_CAPACITY;
+        if (partial == (partial_position[slot] >= 0)) return;
+        vector<int>& slots = product_partial[product];
+        if (partial) {
+            partial_position[slot] = static_cast<int>(slots.size());
+            slots.push_back(slot);
+        } else {
+            int moved = slots.back();
+            slots[partial_position[slot]] = moved;
+            partial_position[moved] = partial_position[slot];
+            slots.pop_back();
+            partial_position[slot] = -1;
+        }
+    }
+
+    // Свободное место в ячейках товара: число его ячеек и остаток ведут Put/Take
+    long long ProductRoom(int product) const {
+        return static_cast<long long>(product_slots[product].size()) * CELL_CAPACITY - product_totals[product];
+    }
+
+    void Put(int slot, int product, int quantity) {
+        int zone = slot / geometry.CellsPerZone();
+        if (quantities[slot] == 0) {
+            products[slot] = product;
+            slot_position[slot] = static_cast<int>(product_slots[product].size());
+            product_slots[product].push_back(slot);
+            free_slots.reset(slot);
+            ++zone_occupied[zone];
+            --empty_cells;
+        }
+        quantities[slot] += quantity;
+        product_totals[product] += quantity;
+        UpdatePartial(slot, product);
+        journal.record({slot, product, quantity});
+        if (wal) LogChange(slot, product, quantity);
+        zone_used[zone] += quantity;
+        used_capacity += quantity;
+    }
+
+    void Take(int slot, int quantity) {
+        int zone = slot / geometry.CellsPerZone();
+        int product = products[slot];
+        journal.record({slot, product, -quantity});
+        if (wal) LogChange(slot, product, -quantity);
+        quantities[slot] -= quantity;
+        product_totals[product] -= quantity;
+        UpdatePartial(slot, product);
+        zone_used[zone] -= quantity;
+        used_capacity -= quantity;
+        if (quantities[slot] == 0) {
+            vector<int>& slots = product_slots[product];
+            int moved = slots.back();
+            slots[slot_position[slot]] = moved;
+            slot_position[moved] = slot_position[slot];
+            slots.pop_back();
+            products[slot] = NO_PRODUCT;
+            free_slots.set(slot);
+            --zone_occupied[zone];
+            ++empty_cells;
+        }
+    }
+
+    void Revert(const Change& change) {
+        if (change.delta > 0) {
+            Take(change.slot, change.delta);
+        } else {
+            Put(change.slot, change.product, -change.delta);
+        }
+    }
+
+    void Apply(const Change& change) {
+        if (change.delta > 0) {
+            Put(change.slot, change.product, change.delta);
+        } else {
+            Take(change.slot, -change.delta);
+        }
+    }
+
+    // Границы операции журнала; внутри пакета операцией является весь пакет
+    void BeginChange() {
+        statPhase(Phase::APPLY);
+        if (!in_batch) journal.begin();
+    }
+
+    void EndChange() {
+        if (in_batch) return;
+        journal.commit();
+        EndOperation();
+    }
+
+    // Первый слот и слот за последним для префикса адреса: недостающие позиции
+    // дополняются первым и последним номером стеллажа, секции и полки
+    bool PrefixBounds(string_view prefix, int& first, int& last) const {
+        if (prefix.size() != 1 && (prefix.size() < 3 || prefix.size() > 5)) return false;
+        string low(prefix);
+        string high(prefix);
+        if (prefix.size() == 1) {
+            low += "01";
+            high += static_cast<char>('0' + geometry.Shelves() / 10);
+            high += static_cast<char>('0' + geometry.Shelves() % 10);
+        }
+        if (prefix.size() <= 3) {
+            low += '1';
+            high += static_cast<char>('0' + geometry.Sections());
+        }
+        if (prefix.size() <= 4) {
+            low += '1';
+            high += static_cast<char>('0' + geometry.Levels());
+        }
+        first = Slot(low);
+        last = Slot(high);
+        if (first < 0 || last < 0) return false;
+        ++last;
+        return true;
+    }
+
+    // Обход отмеченных в range_bits ячеек диапазона, начинающегося со слота first
+    template <typename Visit>
+    void ForEachMarked(int first, Visit visit) const {
+        for (size_t w = 0; w < range_bits.size(); ++w) {
+            for (uint64_t bits = range_bits[w]; bits != 0; bits &= bits - 1) {
+                visit(first + static_cast<int>(w * 64) + __builtin_ctzll(bits));
+            }
+        }
+    }
+
+public:
+    // Аргументы передаются геометрии: для RuntimeGeometry это размеры склада,
+    // у FixedGeometry аргументов нет
+    template <typename... Args>
+    explicit BasicWarehouse(Args... args)
+        : geometry(args...), empty_cells(geometry.CellCount()),
+          quantities(geometry.CellCount(), 0), products(geometry.CellCount(), NO_PRODUCT),
+          slot_position(geometry.CellCount(), 0), partial_position(geometry.CellCount(), -1),
+          zone_used(geometry.Zones(), 0), zone_occupied(geometry.Zones(), 0),
+          free_slots(geometry.CellCount(), true) {}
+
+    int Slot(string_view address) const {
+        return DecodeSlot(geometry, address);
+    }
+
+    string AddressOf(int slot) const {
+        string address(5, '0');
+        address[4] = static_cast<char>('1' + slot % geometry.Levels());
+        slot /= geometry.Levels();
+        address[3] = static_cast<char>('1' + slot % geometry.Sections());
+        slot /= geometry.Sections();
+        int shelf = slot % geometry.Shelves() + 1;
+        address[1] = static_cast<char>('0' + shelf / 10);
+        address[2] = static_cast<char>('0' + shelf % 10);
+        address[0] = static_cast<char>('A' + geometry.FirstZone() + slot / geometry.Shelves());
+        return address;
+    }
+
+    bool Address(const string& address) const {
+        return Slot(address) >= 0;
+    }
+
+    // Операции без вывода: при ошибке возвращают false и не меняют склад,
+    // текст ошибки доступен через LastError(), затронутые ячейки - через LastMoves()
+    bool TryAdd(const string& product, int quantity, const string& address) {
+        moves.clear();
+        int slot = Slot(address);
+        if (slot < 0) return Fail("Неверный адрес: " + address);
+        if (quantity <= 0) return Fail("Количество должно быть положительным числом");
+        if (quantity > CELL_CAPACITY) {
+            return Fail("Нельзя добавить более " + to_string(CELL_CAPACITY) + " единиц в ячейку");
+        }
+
+        int cell_quantity = quantities[slot];
+        int product_id;
+        if (cell_quantity > 0) {
+            const string& stored = product_names[products[slot]];
+            if (stored != product) return Fail("Ячейка " + address + " уже содержит " + stored);
+            if (cell_quantity + quantity > CELL_CAPACITY) {
+                return Fail("Ячейка " + address + " не может содержать более " + to_string(CELL_CAPACITY)
+                            + " единиц (сейчас: " + to_string(cell_quantity) + ")");
+            }
+            product_id = products[slot];
+        } else {
+            product_id = InternProduct(product);
+        }
+        BeginChange();
+        Put(slot, product_id, quantity);
+        EndChange();
+        moves.push_back({slot, quantity});
+        return true;
+    }
+
+    bool TryRemove(const string& product, int quantity, const string& address) {
+        moves.clear();
+        int slot = Slot(address);
+        if (slot < 0) return Fail("Неверный адрес: " + address);
+        if (quantity <= 0) return Fail("Количество должно быть положительным числом");
+
+        int cell_quantity = quantities[slot];
+        if (cell_quantity == 0) return Fail("Ячейка " + address + " пуста");
+
+        const string& stored = product_names[products[slot]];
+        if (stored != product) return Fail("Ячейка " + address + " содержит " + stored + ", а не " + product);
+        if (cell_quantity < quantity) {
+            return Fail("Недостаточно " + product + " в ячейке " + address
+                        + " (доступно: " + to_string(cell_quantity) + ")");
+        }
+
+        BeginChange();
+        Take(slot, quantity);
+        EndChange();
+        moves.push_back({slot, quantity});
+        return true;
+    }
+
+    // Автоматическое размещение: сначала дозаполняются ячейки с тем же товаром,
+    // затем занимаются свободные ячейки в порядке адресов
+    bool TryAdd(const string& product, int quantity) {
+        moves.clear();
+        if (quantity <= 0) return Fail("Количество должно быть положительным числом");
+
+        auto it = product_ids.find(product);
+        long long room = Room(product);
+        if (room < quantity) {
+            return Fail("Недостаточно места для " + to_string(quantity) + " единиц " + product
+                        + " (свободно: " + to_string(room) + ")");
+        }
+
+        int product_id = it != product_ids.end() ? it->second : InternProduct(product);
+        int left = quantity;
+
+        for (int slot : product_partial[product_id]) {
+            if (left == 0) break;
+            int part = min(left, CELL_CAPACITY - quantities[slot]);
+            moves.push_back({slot, part});
+            left -= part;
+        }
+        BeginChange();
+        for (const auto& m : moves) {
+            Put(m.first, product_id, m.second);
+        }
+
+        int slot = 0;
+        while (left > 0) {
+            slot = free_slots.findNext(slot);
+            int part = min(left, CELL_CAPACITY);
+            Put(slot, product_id, part);
+            moves.push_back({slot, part});
+            left -= part;
+        }
+        EndChange();
+        return true;
+    }
+
+    // Автоматический отбор: сначала опустошаются неполные ячейки товара,
+    // затем полные в порядке, обратном размещению
+    bool TryRemove(const string& product, int quantity) {
+        moves.clear();
+        if (quantity <= 0) return Fail("Количество должно быть положительным числом");
+
+        auto it = product_ids.find(product);
+        int available = it == product_ids.end() ? 0 : product_totals[it->second];
+        if (available < quantity) {
+            return Fail("Недостаточно " + product + " на складе (доступно: " + to_string(available) + ")");
+        }
+
+        const vector<int>& slots = product_slots[it->second];
+        int left = quantity;
+        for (int slot : product_partial[it->second]) {
+            if (left == 0) break;
+            int part = min(left, quantities[slot]);
+            moves.push_back({slot, part});
+            left -= part;
+        }
+        for (auto rit = slots.rbegin(); rit != slots.rend() && left > 0; ++rit) {
+            if (quantities[*rit] == CELL_CAPACITY) {
+                int part = min(left, CELL_CAPACITY);
+                moves.push_back({*rit, part});
+                left -= part;
+            }
+        }
+
+        BeginChange();
+        for (const auto& m : moves) {
+            Take(m.first, m.second);
+        }
+        EndChange();
+        return true;
+    }
+
+    // Очистка всех ячеек диапазона слотов [first, last) одной операцией журнала;
+    // очищенные ячейки и их количества доступны через LastMoves()
+    void Clear(int first, int last) {
+        moves.clear();
+        MarkRange(first, last, false);
+        ForEachMarked(first, [this](int slot) { moves.push_back({slot, quantities[slot]}); });
+        if (moves.empty()) return;
+        BeginChange();
+        for (const auto& m : moves) {
+            Take(m.first, m.second);
+        }
+        EndChange();
+    }
+
+    const string& LastError() const {
+        return error;
+    }
+
+    const vector<pair<int, int>>& LastMoves() const {
+        return moves;
+    }
+
+    // Пакетный режим: изменения ячеек копятся в открытой операции журнала,
+    // чтобы пакет можно было откатить или потом отменить целиком
+    void BeginBatch() {
+        journal.begin();
+        in_batch = true;
+    }
+
+    void CommitBatch() {
+        journal.commit();
+        in_batch = false;
+        EndOperation();
+    }
+
+    void RollbackBatch() {
+        in_batch = false;
+        journal.rollback([this](const Change& change) { Revert(change); });
+        if (wal) wal->discard();
+    }
+
+    // Отмена и повтор последней операции; возвращают число изменённых ячеек, 0 - нечего отменять
+    size_t Undo() {
+        size_t changes = journal.undo([this](const Change& change) { Revert(change); });
+        EndOperation();
+        return changes;
+    }
+
+    size_t Redo() {
+        size_t changes = journal.redo([this](const Change& change) { Apply(change); });
+        EndOperation();
+        return changes;
+    }
+
+    // Хранение на диске: подключение журнала и восстановление состояния.
+    // Replay* проверяют запись и возвращают false для несогласованных данных
+    void AttachLog(WriteAheadLog* log) {
+        wal = log;
+    }
+
+    bool ReplayProduct(int id, const string& name) {
+        if (id != static_cast<int>(product_names.size()) || product_ids.count(name)) return false;
+        InternProduct(name);
+        return true;
+    }
+
+    bool ReplayChange(int slot, int product, int delta) {
+        if (slot < 0 || slot >= geometry.CellCount() || product < 0 || product >= static_cast<int>(product_names.size())) {
+            return false;
+        }
+        if (delta > 0) {
+            if (quantities[slot] > 0 && products[slot] != product) return false;
+            if (quantities[slot] + delta > CELL_CAPACITY) return false;
+            Put(slot, product, delta);
+        } else {
+            if (quantities[slot] == 0 || products[slot] != product || quantities[slot] < -delta || delta == 0) return false;
+            Take(slot, -delta);
+        }
+        return true;
+    }
+
+    int CellCount() const {
+        return geometry.CellCount();
+    }
+
+    int CellQuantity(int slot) const {
+        return quantities[slot];
+    }
+
+    int CellProduct(int slot) const {
+        return products[slot];
+    }
+
+    const vector<string>& ProductNames() const {
+        return product_names;
+    }
+
+    // Запросы для составного склада (ShardedWarehouse)
+    int TotalCapacity() const {
+        return geometry.TotalCapacity();
+    }
+
+    int UsedCapacity() const {
+        return used_capacity;
+    }
+
+    int EmptyCells() const {
+        return empty_cells;
+    }
+
+    // Сколько единиц товара поместится при автоматическом размещении
+    long long Room(const string& product) const {
+        auto it = product_ids.find(product);
+        long long room = static_cast<long long>(empty_cells) * CELL_CAPACITY;
+        return it == product_ids.end() ? room : room + ProductRoom(it->second);
+    }
+
+    int Stock(const string& product) const {
+        auto it = product_ids.find(product);
+        return it == product_ids.end() ? 0 : product_totals[it->second];
+    }
+
+    // Диапазон слотов [first, last) по префиксу адреса: A - зона, A03 - стеллаж,
+    // A035 - секция, A0351 - ячейка. Два префикса через дефис (A01-A03, A0351-B)
+    // задают диапазон от начала первого до конца второго
+    bool SlotRange(string_view range, int& first, int& last) const {
+        size_t dash = range.find('-');
+        string_view from = range.substr(0, dash);
+        string_view to = dash == string_view::npos ? from : range.substr(dash + 1);
+        int unused;
+        return PrefixBounds(from, first, unused) && PrefixBounds(to, unused, last) && first < last;
+    }
+
+    // Сумма единиц и число занятых ячеек в диапазоне слотов
+    CellTotals CountRange(int first, int last) const {
+        return sumCells(quantities.data() + first, static_cast<size_t>(last - first));
+    }
+
+    // Отмечает в range_bits пустые (empty) или занятые ячейки диапазона; возвращает их число
+    size_t MarkRange(int first, int last, bool empty) const {
+        size_t count = static_cast<size_t>(last - first);
+        range_bits.resize((count + 63) / 64);
+        return markCells(quantities.data() + first, count, empty, range_bits.data());
+    }
+
+    // Ячейки товара в порядке адресов: (слот, количество)
+    vector<pair<int, int>> ProductCells(const string& product) const {
+        vector<pair<int, int>> cells;
+        auto it = product_ids.find(product);
+        if (it == product_ids.end()) return cells;
+        for (int slot : product_slots[it->second]) {
+            cells.push_back({slot, quantities[slot]});
+        }
+        sort(cells.begin(), cells.end());
+        return cells;
+    }
+
+    // Печатает до limit занятых ячеек начиная со слота from; возвращает число
+    // напечатанных, а в next - следующую занятую ячейку или -1, если их больше нет
+    int PrintCells(int from, int limit, Output& sink, int& next) const {
+        int shown = 0;
+        next = -1;
+        for (int slot = from; slot < geometry.CellCount(); ++slot) {
+            if (quantities[slot] == 0) continue;
+            if (shown == limit) {
+                next = slot;
+                break;
+            }
+            sink << AddressOf(slot) << ": " << product_names[products[slot]] << " (" << quantities[slot] << ")" << '\n';
+            ++shown;
+        }
+        return shown;
+    }
+
+    void PrintZones(Output& sink) const {
+        int zone_capacity = geometry.CellsPerZone() * CELL_CAPACITY;
+        for (int zone = 0; zone < geometry.Zones(); ++zone) {
+            double zone_percent = (static_cast<double>(zone_used[zone]) / zone_capacity) * 100;
+            sink << "Зона " << static_cast<char>('A' + geometry.FirstZone() + zone) << " заполнена на " << Fixed{zone_percent, 1} << "%"
+                 << " (занято ячеек: " << zone_occupied[zone] << ")" << '\n';
+        }
+    }
+
+    // Команды с выводом; sink - куда писать ответ, по умолчанию stdout.
+    // ADD и REMOVE с адресом возвращают true, если склад изменён
+    bool ADD(const string& product, int quantity, const string& address, Output& sink = out) {
+        statPhase(Phase::VALIDATE);
+        if (!TryAdd(product, quantity, address)) {
+            sink << "Ошибка: " << error << '\n';
+            return false;
+        }
+        statPhase(Phase::PRINT);
+        sink << "Добавлено " << quantity << " единиц " << product << " в " << address << '\n';
+        return true;
+    }
+
+    bool REMOVE(const string& product, int quantity, const string& address, Output& sink = out) {
+        statPhase(Phase::VALIDATE);
+        if (!TryRemove(product, quantity, address)) {
+            sink << "Ошибка: " << error << '\n';
+            return false;
+        }
+        statPhase(Phase::PRINT);
+        sink << "Удалено " << quantity << " единиц " << product << " из " << address << '\n';
+        return true;
+    }
+
+    void ADD(const string& product, int quantity, Output& sink = out) {
+        statPhase(Phase::VALIDATE);
+        if (!TryAdd(product, quantity)) {
+            sink << "Ошибка: " << error << '\n';
+            return;
+        }
+        statPhase(Phase::PRINT);
+        sink << "Добавлено " << quantity << " единиц " << product << ":";
+        PrintMoves('+', sink);
+    }
+
+    void REMOVE(const string& product, int quantity, Output& sink = out) {
+        statPhase(Phase::VALIDATE);
+        if (!TryRemove(product, quantity)) {
+            sink << "Ошибка: " << error << '\n';
+            return;
+        }
+        statPhase(Phase::PRINT);
+        sink << "Удалено " << quantity << " единиц " << product << ":";
+        PrintMoves('-', sink);
+    }
+
+    void INFO(Output& sink = out) const {
+        statPhase(Phase::PRINT);
+        double total_percent = (static_cast<double>(used_capacity) / geometry.TotalCapacity()) * 100;
+        sink << "Информация о складе:" << '\n';
+        sink << "Общая заполненность: " << Fixed{total_percent, 1} << "%" << '\n';
+        PrintZones(sink);
+        sink << "\nПустые ячейки: " << empty_cells << '\n';
+    }
+
+    void FIND(const string& product, Output& sink = out) const {
+        statPhase(Phase::APPLY);
+        vector<pair<int, int>> cells = ProductCells(product);
+        statPhase(Phase::PRINT);
+        if (cells.empty()) {
+            sink << "Товар " << product << " не найден на складе" << '\n';
+            return;
+        }
+        sink << "Товар " << product << ":";
+        for (size_t i = 0; i < cells.size(); ++i) {
+            if (i != 0) sink << ",";
+            sink << " " << AddressOf(cells[i].first) << " (" << cells[i].second << ")";
+        }
+        sink << '\n';
+    }
+
+    void STOCK(const string& product, Output& sink = out) const {
+        auto it = product_ids.find(product);
+        int cells = it == product_ids.end() ? 0 : static_cast<int>(product_slots[it->second].size());
+        sink << "Остаток " << product << ": " << Stock(product) << " единиц в " << cells << " ячейках" << '\n';
+    }
+
+    // Постраничный вывод занятых ячеек начиная с адреса from
+    void CELLS(const string& from, int limit, Output& sink = out) const {
+        int slot = 0;
+        if (!from.empty()) {
+            slot = Slot(from);
+            if (slot < 0) {
+                sink << "Ошибка: Неверный адрес: " << from << '\n';
+                return;
+            }
+        }
+
+        sink << "Занятые ячейки:" << '\n';
+        int next;
+        PrintCells(slot, limit, sink, next);
+        if (next >= 0) sink << "Далее: CELLS " << AddressOf(next) << " " << limit << '\n';
+    }
+
+    // Команды над диапазоном ячеек (см. SlotRange)
+    void COUNT(const string& range, Output& sink = out) const {
+        statPhase(Phase::VALIDATE);
+        int first, last;
+        if (!SlotRange(range, first, last)) {
+            sink << "Ошибка: Неверный диапазон: " << range << '\n';
+            return;
+        }
+        statPhase(Phase::APPLY);
+        CellTotals totals = CountRange(first, last);
+        statPhase(Phase::PRINT);
+        sink << "Диапазон " << range << ": " << totals.units << " единиц в " << totals.occupied
+             << " ячейках, пустых ячеек: " << last - first - totals.occupied << '\n';
+    }
+
+    // Пустые ячейки диапазона, не больше limit адресов
+    void EMPTY(const string& range, int limit, Output& sink = out) const {
+        statPhase(Phase::VALIDATE);
+        int first, last;
+        if (!SlotRange(range, first, last)) {
+            sink << "Ошибка: Неверный диапазон: " << range << '\n';
+            return;
+        }
+        statPhase(Phase::APPLY);
+        size_t empty = MarkRange(first, last, true);
+        statPhase(Phase::PRINT);
+        sink << "Пустые ячейки " << range << " (" << empty << " из " << last - first << "):";
+        int shown = 0;
+        ForEachMarked(first, [&](int slot) {
+            if (shown < limit) sink << (shown == 0 ? " " : ", ") << AddressOf(slot);
+            ++shown;
+        });
+        if (shown > limit) sink << " и ещё " << shown - limit;
+        sink << '\n';
+    }
+
+    void CLEAR(const string& range, Output& sink = out) {
+        statPhase(Phase::VALIDATE);
+        int first, last;
+        if (!SlotRange(range, first, last)) {
+            sink << "Ошибка: Неверный диапазон: " << range << '\n';
+            return;
+        }
+        statPhase(Phase::APPLY);
+        Clear(first, last);
+        statPhase(Phase::PRINT);
+        long long units = 0;
+        for (const auto& m : moves) {
+            units += m.second;
+        }
+        sink << "Очищено " << range << ": " << units << " единиц из " << moves.size() << " ячеек" << '\n';
+    }
+};
+
+// Склад с размерами, заданными при запуске: Warehouse(зоны, стеллажи, секции, полки, вместимость)
+using Warehouse = BasicWarehouse<RuntimeGeometry>;
+
+// Склад с размерами, известными при компиляции, например FixedWarehouse<1, 10, 7, 4, 10>
+template <int Z, int S, int Sec, int L, int CellCap>
+using FixedWarehouse = BasicWarehouse<FixedGeometry<Z, S, Sec, L, CellCap>>;
+
+// Склад, разделённый на шарды по зонам: каждая зона - отдельный Warehouse со своим
+// мьютексом. Операции с адресом блокируют только свою зону и из разных потоков
+// идут параллельно. Автоматическое размещение и отбор, INFO, FIND, STOCK и CELLS
+// блокируют все зоны по порядку и видят согласованное состояние склада.
+// Автоматическое размещение идёт зона за зоной: в каждой зоне сначала дозаполняются
+// ячейки товара, затем занимаются свободные
+class ShardedWarehouse {
+private:
+    struct Shard {
+        mutex lock;
+        Warehouse warehouse;
+
+        Shard(int spz, int sec, int spl, int capacity, int zone)
+            : warehouse(1, spz, sec, spl, capacity, zone) {}
+    };
+
+    vector<unique_ptr<Shard>> shards;
+
+    // Все мьютексы в порядке зон: одинаковый порядок исключает взаимоблокировку
+    class LockAll {
+    private:
+        vector<unique_lock<mutex>> locks;
+
+    public:
+        explicit LockAll(const vector<unique_ptr<Shard>>& shards) {
+            locks.reserve(shards.size());
+            for (const auto& shard : shards) {
+                locks.emplace_back(shard->lock);
+            }
+        }
+    };
+
+    Shard* ShardFor(string_view address) const {
+        if (address.empty()) return nullptr;
+        int zone = address[0] - 'A';
+        if (zone < 0 || zone >= static_cast<int>(shards.size())) return nullptr;
+        return shards[zone].get();
+    }
+
+    static void PrintMoves(const Warehouse& warehouse, char sign, bool& first, Output& sink) {
+        for (const auto& move : warehouse.LastMoves()) {
+            if (!first) sink << ",";
+            sink << " " << warehouse.AddressOf(move.first) << " (" << sign << move.second << ")";
+            first = false;
+        }
+    }
+
+public:
+    ShardedWarehouse(int zones, int spz, int sec, int spl, int zone_capacity) {
+        for (int zone = 0; zone < zones; ++zone) {
+            shards.push_back(make_unique<Shard>(spz, sec, spl, zone_capacity, zone));
+        }
+    }
+
+    // Операции с адресом возвращают true, если склад изменён
+    bool ADD(const string& product, int quantity, const string& address, Output& sink) {
+        Shard* shard = ShardFor(address);
+        if (!shard) {
+            sink << "Ошибка: Неверный адрес: " << address << '\n';
+            return false;
+        }
+        lock_guard<mutex> guard(shard->lock);
+        return shard->warehouse.ADD(product, quantity, address, sink);
+    }
+
+    bool REMOVE(const string& product, int quantity, const string& address, Output& sink) {
+        Shard* shard = ShardFor(address);
+        if (!shard) {
+            sink << "Ошибка: Неверный адрес: " << address << '\n';
+            return false;
+        }
+        lock_guard<mutex> guard(shard->lock);
+        return shard->warehouse.REMOVE(product, quantity, address, sink);
+    }
+
+    void ADD(const string& product, int quantity, Output& sink) {
+        if (quantity <= 0) {
+            sink << "Ошибка: Количество должно быть положительным числом" << '\n';
+            return;
+        }
+        LockAll all(shards);
+        vector<long long> room(shards.size());
+        long long total = 0;
+        for (size_t i = 0; i < shards.size(); ++i) {
+            room[i] = shards[i]->warehouse.Room(product);
+            total += room[i];
+        }
+        if (total < quantity) {
+            sink << "Ошибка: Недостаточно места для " << quantity << " единиц " << product
+                 << " (свободно: " << total << ")" << '\n';
+            return;
+        }
+
+        sink << "Добавлено " << quantity << " единиц " << product << ":";
+        int left = quantity;
+        bool first = true;
+        for (size_t i = 0; i < shards.size() && left > 0; ++i) {
+            int part = static_cast<int>(min<long long>(left, room[i]));
+            if (part == 0) continue;
+            shards[i]->warehouse.TryAdd(product, part);
+            PrintMoves(shards[i]->warehouse, '+', first, sink);
+            left -= part;
+        }
+        sink << '\n';
+    }
+
+    void REMOVE(const string& product, int quantity, Output& sink) {
+        if (quantity <= 0) {
+            sink << "Ошибка: Количество должно быть положительным числом" << '\n';
+            return;
+        }
+        LockAll all(shards);
+        long long available = 0;
+        for (const auto& shard : shards) {
+            available += shard->warehouse.Stock(product);
+        }
+        if (available < quantity) {
+            sink << "Ошибка: Недостаточно " << product << " на складе (доступно: " << available << ")" << '\n';
+            return;
+        }
+
+        sink << "Удалено " << quantity << " единиц " << product << ":";
+        int left = quantity;
+        bool first = true;
+        for (size_t i = 0; i < shards.size() && left > 0; ++i) {
+            int part = min(left, shards[i]->warehouse.Stock(product));
+            if (part == 0) continue;
+            shards[i]->warehouse.TryRemove(product, part);
+            PrintMoves(shards[i]->warehouse, '-', first, sink);
+            left -= part;
+        }
+        sink << '\n';
+    }
+
+    void INFO(Output& sink) const {
+        LockAll all(shards);
+        long long used = 0;
+        long long capacity = 0;
+        long long empty = 0;
+        for (const auto& shard : shards) {
+            used += shard->warehouse.UsedCapacity();
+            capacity += shard->warehouse.TotalCapacity();
+            empty += shard->warehouse.EmptyCells();
+        }
+        sink << "Информация о складе:" << '\n';
+        sink << "Общая заполненность: " << Fixed{static_cast<double>(used) / capacity * 100, 1} << "%" << '\n';
+        for (const auto& shard : shards) {
+            shard->warehouse.PrintZones(sink);
+        }
+        sink << "\nПустые ячейки: " << empty << '\n';
+    }
+
+    void FIND(const string& product, Output& sink) const {
+        LockAll all(shards);
+        bool first = true;
+        for (const auto& shard : shards) {
+            for (const auto& cell : shard->warehouse.ProductCells(product)) {
+                sink << (first ? "Товар " + product + ":" : string(",")) << " "
+                     << shard->warehouse.AddressOf(cell.first) << " (" << cell.second << ")";
+                first = false;
+            }
+        }
+        if (first) {
+            sink << "Товар " << product << " не найден на складе" << '\n';
+            return;
+        }
+        sink << '\n';
+    }
+
+    void STOCK(const string& product, Output& sink) const {
+        LockAll all(shards);
+        long long total = 0;
+        size_t cells = 0;
+        for (const auto& shard : shards) {
+            total += shard->warehouse.Stock(product);
+            cells += shard->warehouse.ProductCells(product).size();
+        }
+        sink << "Остаток " << product << ": " << total << " единиц в " << cells << " ячейках" << '\n';
+    }
+
+    void CELLS(const string& from, int limit, Output& sink) const {
+        size_t start = 0;
+        int slot = 0;
+        if (!from.empty()) {
+            Shard* shard = ShardFor(from);
+            slot = shard ? shard->warehouse.Slot(from) : -1;
+            if (slot < 0) {
+                sink << "Ошибка: Неверный адрес: " << from << '\n';
+                return;
+            }
+            start = static_cast<size_t>(from[0] - 'A');
+        }
+
+        LockAll all(shards);
+        sink << "Занятые ячейки:" << '\n';
+        int left = limit;
+        for (size_t i = start; i < shards.size(); ++i, slot = 0) {
+            int next;
+            left -= shards[i]->warehouse.PrintCells(slot, left, sink, next);
+            if (next >= 0) {
+                sink << "Далее: CELLS " << shards[i]->warehouse.AddressOf(next) << " " << limit << '\n';
+                return;
+            }
+        }
+    }
+};
+
+#endif